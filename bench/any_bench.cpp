@@ -0,0 +1,855 @@
+#include "bench/bench.hpp"
+#include "src/any.hpp"
+#include "src/any_map.hpp"
+#include "src/any_vector.hpp"
+#include "src/arena_any.hpp"
+#include "src/any_visit.hpp"
+#include "src/atomic_any.hpp"
+#include "src/inplace_function.hpp"
+#include "src/lazy_any.hpp"
+#include "src/poly.hpp"
+#include "src/recycling_allocator.hpp"
+#include "src/relocating_vector.hpp"
+#include "src/shared_any.hpp"
+#include "src/variant.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace {
+    constexpr std::size_t element_count = 1000000;
+
+    struct pod {
+        int i;
+        float f;
+        double d;
+    };
+
+    // the hand written alternative for a closed set of trivial types
+    struct tagged_union {
+        enum class tag { empty, integer, real, record } kind;
+        union {
+            int i;
+            double d;
+            pod p;
+        };
+
+        tagged_union() : kind{tag::empty} {}
+        tagged_union(int i) : kind{tag::integer}, i{i} {}
+        tagged_union(double d) : kind{tag::real}, d{d} {}
+        tagged_union(pod p) : kind{tag::record}, p{p} {}
+    };
+
+    template<typename Value>
+    void bench_trivial_values(const char *construct_label, const char *copy_label, const char *destroy_label) {
+        std::vector<Value> values;
+        values.reserve(element_count);
+
+        bench::measure(construct_label, element_count, [&] {
+            for (std::size_t i = 0; i < element_count; ++i) {
+                switch (i % 3) {
+                case 0: values.emplace_back(static_cast<int>(i)); break;
+                case 1: values.emplace_back(static_cast<double>(i)); break;
+                default: values.emplace_back(pod{static_cast<int>(i), 1.0f, 2.0}); break;
+                }
+            }
+        });
+
+        std::vector<Value> *copies = nullptr;
+        bench::measure(copy_label, element_count, [&] {
+            copies = new std::vector<Value>(values);
+        });
+        bench::keep(copies->back());
+
+        bench::measure(destroy_label, element_count, [&] {
+            delete copies;
+        });
+    }
+}
+
+BENCHMARK_CASE("std::vector<any> of int/double/pod vs tagged union") {
+    bench_trivial_values<any>("any: construct", "any: copy vector", "any: destroy vector");
+    bench_trivial_values<tagged_union>("tagged union: construct", "tagged union: copy vector", "tagged union: destroy vector");
+
+    std::vector<any> values(element_count, any(1));
+    bench::measure("any: reset", element_count, [&] {
+        for (any &value : values)
+            value.reset();
+    });
+}
+
+namespace {
+    struct heap_value {
+        char raw[48];
+        std::size_t i;
+
+        heap_value(std::size_t i) : raw{}, i{i} {}
+        heap_value(const heap_value &) = default;
+        // a throwing move keeps the value out of the inline buffer
+        heap_value(heap_value &&other) noexcept(false) : heap_value(other) {}
+    };
+
+    template<typename Any>
+    void bench_heap_values(const char *construct_label, const char *destroy_label) {
+        std::vector<Any> values;
+        values.reserve(element_count);
+        bench::measure(construct_label, element_count, [&] {
+            for (std::size_t i = 0; i < element_count; ++i)
+                values.emplace_back(heap_value(i));
+        });
+        bench::keep(values.back());
+
+        bench::measure(destroy_label, element_count, [&] {
+            values.clear();
+        });
+    }
+}
+
+BENCHMARK_CASE("any heap values from the small object allocator vs operator new") {
+    bench_heap_values<any>("any: small object allocator construct", "any: small object allocator destroy");
+    bench_heap_values<basic_any<2*sizeof(void*), alignof(void*), std::allocator<std::byte>>>("any: std::allocator construct", "any: std::allocator destroy");
+}
+
+namespace {
+    constexpr std::size_t growth_count = 10000000;
+
+    struct record {
+        std::size_t i;
+        char raw[40];
+    };
+
+    // an any whose move may throw, which is how std::vector saw any before its move became noexcept
+    struct throwing_move_any : any {
+        using any::any;
+
+        throwing_move_any(const throwing_move_any &) = default;
+        throwing_move_any(throwing_move_any &&other) noexcept(false) : any(std::move(other)) {}
+    };
+
+    template<typename Vector>
+    void bench_growth(const char *label) {
+        Vector values;
+        bench::measure(label, growth_count, [&] {
+            for (std::size_t i = 0; i < growth_count; ++i) {
+                if (i % 2 == 0)
+                    values.emplace_back(static_cast<int>(i));
+                else
+                    values.emplace_back(record{i, {}});
+            }
+        });
+        bench::keep(values.back());
+    }
+}
+
+BENCHMARK_CASE("growing a vector of 10M any holding int/heap record") {
+    bench_growth<std::vector<throwing_move_any>>("std::vector, copying any (before)");
+    bench_growth<std::vector<any>>("std::vector, noexcept move any");
+    // any may hold inline values that cannot be relocated bitwise, so relocating_vector grows it with the
+    // noexcept move. relocatable_any puts those values on the heap and is grown with realloc
+    bench_growth<relocating_vector<any>>("relocating_vector, noexcept move any");
+    bench_growth<relocating_vector<relocatable_any>>("relocating_vector, realloc relocatable_any");
+}
+
+namespace {
+    template<int N>
+    struct message {
+        int payload;
+    };
+
+    template<class Sequence>
+    struct message_list_impl;
+
+    template<int... Ns>
+    struct message_list_impl<std::integer_sequence<int, Ns...>> {
+        using type = TL::type_list<message<Ns>...>;
+    };
+
+    template<int N>
+    using message_list = typename message_list_impl<std::make_integer_sequence<int, N>>::type;
+
+    template<int... Ns>
+    long cast_chain(const any &value, std::integer_sequence<int, Ns...>) {
+        long result = -1;
+        ((any_cast<message<Ns>>(&value) != nullptr ? (result = any_cast<message<Ns>>(&value)->payload + Ns, true) : false) || ...);
+        return result;
+    }
+
+    template<int... Ns>
+    std::vector<any> make_messages(std::integer_sequence<int, Ns...>) {
+        using factory = any (*)(int);
+        constexpr factory factories[] = {[](int i) { return any(message<Ns>{i}); }...};
+
+        std::vector<any> values;
+        values.reserve(element_count);
+        for (std::size_t i = 0; i < element_count; ++i)
+            values.push_back(factories[(i * 7919) % sizeof...(Ns)](static_cast<int>(i)));
+        return values;
+    }
+
+    template<int N>
+    void bench_dispatch(const char *chain_label, const char *visit_label) {
+        std::vector<any> values = make_messages(std::make_integer_sequence<int, N>{});
+
+        long chain_sum = 0;
+        bench::measure(chain_label, element_count, [&] {
+            for (const any &value : values)
+                chain_sum += cast_chain(value, std::make_integer_sequence<int, N>{});
+        });
+        bench::keep(chain_sum);
+
+        long visit_sum = 0;
+        bench::measure(visit_label, element_count, [&] {
+            for (const any &value : values) {
+                visit_sum += visit<message_list<N>>(value, [](const auto &m) -> long { return m.payload; },
+                                                    [](const any &) -> long { return -1; });
+            }
+        });
+        bench::keep(visit_sum);
+    }
+
+    // values of a type outside the list take the fallback
+    template<int N>
+    void bench_dispatch_miss(const char *visit_label) {
+        std::vector<any> values(element_count, any(1.5));
+
+        long visit_sum = 0;
+        bench::measure(visit_label, element_count, [&] {
+            for (const any &value : values) {
+                visit_sum += visit<message_list<N>>(value, [](const auto &m) -> long { return m.payload; },
+                                                    [](const any &) -> long { return -1; });
+            }
+        });
+        bench::keep(visit_sum);
+    }
+}
+
+BENCHMARK_CASE("any dispatch: any_cast chain vs visit") {
+    bench_dispatch<4>("4 types: any_cast chain", "4 types: visit");
+    bench_dispatch<16>("16 types: any_cast chain", "16 types: visit");
+    bench_dispatch<64>("64 types: any_cast chain", "64 types: visit");
+    bench_dispatch_miss<4>("4 types: visit of another type");
+    bench_dispatch_miss<64>("64 types: visit of another type");
+}
+
+namespace {
+    constexpr std::size_t consumer_count = 32;
+    constexpr std::size_t broadcast_count = 10000;
+
+    struct parsed_document {
+        std::vector<char> bytes;
+        std::string title;
+    };
+
+    template<typename Any>
+    void bench_fan_out(const char *label, std::size_t payload_size) {
+        std::vector<Any> consumers(consumer_count);
+        Any payload = parsed_document{std::vector<char>(payload_size, 'x'), "title"};
+
+        std::size_t read = 0;
+        bench::measure(label, broadcast_count * consumer_count, [&] {
+            for (std::size_t i = 0; i < broadcast_count; ++i) {
+                for (Any &consumer : consumers)
+                    consumer = payload;
+                for (const Any &consumer : consumers)
+                    read += any_cast<const parsed_document &>(consumer).bytes.size();
+            }
+        });
+        bench::keep(read);
+    }
+}
+
+BENCHMARK_CASE("fan-out of a large payload to 32 consumers: any vs shared_any") {
+    bench_fan_out<any>("any: 1 KB payload", 1024);
+    bench_fan_out<shared_any>("shared_any: 1 KB payload", 1024);
+    bench_fan_out<any>("any: 64 KB payload", 64 * 1024);
+    bench_fan_out<shared_any>("shared_any: 64 KB payload", 64 * 1024);
+}
+
+namespace {
+    constexpr std::size_t reads_per_thread = 200000;
+
+    struct tunables {
+        int timeout_ms;
+        int retries;
+    };
+
+    class locked_any {
+    public:
+        template<typename F>
+        int read(F &&f) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return f(value);
+        }
+
+        void store(any next) {
+            std::lock_guard<std::mutex> lock(mutex);
+            value = std::move(next);
+        }
+
+    private:
+        mutable std::mutex mutex;
+        any value = tunables{100, 3};
+    };
+
+    // reader_count threads read the settings while one writer replaces them until the readers are done
+    template<typename Settings>
+    void bench_settings(const char *label, std::size_t reader_count) {
+        Settings settings;
+        settings.store(tunables{100, 3});
+        std::atomic<bool> done{false};
+        std::atomic<long> sum{0};
+
+        bench::measure(label, reader_count * reads_per_thread, [&] {
+            std::thread writer([&] {
+                for (int i = 0; !done.load(std::memory_order_relaxed); ++i) {
+                    settings.store(tunables{100 + i % 7, 3});
+                    std::this_thread::yield();
+                }
+            });
+
+            std::vector<std::thread> readers;
+            for (std::size_t t = 0; t < reader_count; ++t) {
+                readers.emplace_back([&] {
+                    long local = 0;
+                    for (std::size_t i = 0; i < reads_per_thread; ++i)
+                        local += settings.read([](const any &v) { return any_cast<const tunables &>(v).timeout_ms; });
+                    sum += local;
+                });
+            }
+
+            for (std::thread &reader : readers)
+                reader.join();
+            done = true;
+            writer.join();
+        });
+        bench::keep(sum);
+    }
+}
+
+BENCHMARK_CASE("settings read by 1/8/64 threads with one writer: mutex vs atomic_any") {
+    bench_settings<locked_any>("mutex: 1 reader", 1);
+    bench_settings<atomic_any>("atomic_any: 1 reader", 1);
+    bench_settings<locked_any>("mutex: 8 readers", 8);
+    bench_settings<atomic_any>("atomic_any: 8 readers", 8);
+    bench_settings<locked_any>("mutex: 64 readers", 64);
+    bench_settings<atomic_any>("atomic_any: 64 readers", 64);
+}
+
+namespace {
+    constexpr std::size_t field_count = 100000;
+
+    // every third field holds a string where the parser first tries an int
+    std::vector<any> make_fields() {
+        std::vector<any> fields;
+        fields.reserve(field_count);
+        for (std::size_t i = 0; i < field_count; ++i) {
+            if (i % 3 == 0)
+                fields.emplace_back(std::string("field"));
+            else
+                fields.emplace_back(static_cast<int>(i));
+        }
+        return fields;
+    }
+}
+
+BENCHMARK_CASE("parsing fields with 1/3 mismatches: any_cast exceptions vs try_any_cast") {
+    std::vector<any> fields = make_fields();
+
+    long throwing_sum = 0;
+    bench::measure("any_cast<int>, catching bad_any_cast", field_count, [&] {
+        for (const any &field : fields) {
+            try {
+                throwing_sum += any_cast<int>(field);
+            }
+            catch (const bad_any_cast &) {
+                throwing_sum += static_cast<long>(any_cast<const std::string &>(field).size());
+            }
+        }
+    });
+    bench::keep(throwing_sum);
+
+    long try_sum = 0;
+    bench::measure("try_any_cast<int>", field_count, [&] {
+        for (const any &field : fields) {
+            if (auto value = try_any_cast<int>(field))
+                try_sum += *value;
+            else
+                try_sum += static_cast<long>(unchecked_any_cast<std::string>(field).size());
+        }
+    });
+    bench::keep(try_sum);
+}
+
+namespace {
+    struct alignas(32) lanes8 {
+        float lanes[8];
+    };
+
+    template<typename Any>
+    void bench_lanes(const char *label) {
+        std::vector<Any> values;
+        bench::measure(label, element_count, [&] {
+            values.reserve(element_count);
+            for (std::size_t i = 0; i < element_count; ++i)
+                values.emplace_back(lanes8{{static_cast<float>(i), 1, 2, 3, 4, 5, 6, 7}});
+
+            float sum = 0;
+            for (const Any &value : values) {
+                for (float lane : any_cast<const lanes8 &>(value).lanes)
+                    sum += lane;
+            }
+            bench::keep(sum);
+        });
+    }
+}
+
+BENCHMARK_CASE("1M alignas(32) values: any vs aligned_any<32>") {
+    bench_lanes<any>("any (aligned heap)");
+    bench_lanes<aligned_any<32>>("aligned_any<32> (inline)");
+}
+
+namespace {
+    constexpr std::size_t call_count = 10000000;
+
+    long scaled(long i) {
+        return 3 * i;
+    }
+
+    template<typename Callback>
+    void bench_calls(const char *label, const std::vector<Callback> &callbacks) {
+        long sum = 0;
+        bench::measure(label, call_count, [&] {
+            for (std::size_t i = 0; i < call_count; ++i)
+                sum += callbacks[i % callbacks.size()](static_cast<long>(i));
+        });
+        bench::keep(sum);
+    }
+
+    // callbacks capturing 32 bytes, more than std::function keeps inline
+    template<typename Callback>
+    void bench_construct_and_call(const char *label) {
+        long sum = 0;
+        bench::measure(label, call_count / 10, [&] {
+            for (std::size_t i = 0; i < call_count / 10; ++i) {
+                long a = static_cast<long>(i), b = 1, c = 2, d = 3;
+                Callback callback = [a, b, c, d](long x) { return a + b + c + d + x; };
+                bench::keep(callback);
+                sum += callback(1);
+            }
+        });
+        bench::keep(sum);
+    }
+}
+
+BENCHMARK_CASE("callbacks: function pointer vs std::function vs inplace_function vs function_ref") {
+    long a = 1, b = 2, c = 3, d = 4;
+    auto lambda = [a, b, c, d](long x) { return a + b + c + d + x; };
+
+    bench_calls("function pointer: call", std::vector<long (*)(long)>(8, &scaled));
+    bench_calls("std::function: call", std::vector<std::function<long(long)>>(8, lambda));
+    bench_calls("inplace_function<32 bytes>: call", std::vector<inplace_function<long(long), 32>>(8, lambda));
+    bench_calls("function_ref: call", std::vector<function_ref<long(long)>>(8, lambda));
+
+    bench_construct_and_call<std::function<long(long)>>("std::function: construct and call");
+    bench_construct_and_call<inplace_function<long(long), 32>>("inplace_function<32 bytes>: construct and call");
+}
+
+namespace {
+    constexpr std::size_t sort_count = 1000000;
+
+    // orders int < double < std::string, then by value
+    bool any_less(const any &lhs, const any &rhs) {
+        auto rank = [](const any &v) {
+            return any_cast<int>(&v) != nullptr ? 0 : any_cast<double>(&v) != nullptr ? 1 : 2;
+        };
+
+        int lhs_rank = rank(lhs), rhs_rank = rank(rhs);
+        if (lhs_rank != rhs_rank)
+            return lhs_rank < rhs_rank;
+        if (lhs_rank == 0)
+            return *any_cast<int>(&lhs) < *any_cast<int>(&rhs);
+        if (lhs_rank == 1)
+            return *any_cast<double>(&lhs) < *any_cast<double>(&rhs);
+        return *any_cast<std::string>(&lhs) < *any_cast<std::string>(&rhs);
+    }
+
+    template<typename Value>
+    std::vector<Value> make_mixed_values() {
+        std::vector<Value> values;
+        values.reserve(sort_count);
+        unsigned state = 12345;
+        for (std::size_t i = 0; i < sort_count; ++i) {
+            state = state * 1103515245 + 12345;
+            int r = static_cast<int>(state >> 8);
+            if (i % 3 == 0)
+                values.emplace_back(r);
+            else if (i % 3 == 1)
+                values.emplace_back(r / 7.0);
+            else
+                values.emplace_back(std::to_string(r));
+        }
+        return values;
+    }
+}
+
+BENCHMARK_CASE("sorting 1M int/double/string values: any_cast comparator vs poly<less>") {
+    std::vector<any> values = make_mixed_values<any>();
+    bench::measure("std::vector<any> with an any_cast comparator", sort_count, [&] {
+        std::sort(values.begin(), values.end(), any_less);
+    });
+    bench::keep(values);
+
+    std::vector<poly<any_ops::less>> polys = make_mixed_values<poly<any_ops::less>>();
+    bench::measure("std::vector<poly<less>>", sort_count, [&] {
+        std::sort(polys.begin(), polys.end());
+    });
+    bench::keep(polys);
+}
+
+namespace {
+    template<class List>
+    struct std_variant_of;
+
+    template<class... Ts>
+    struct std_variant_of<TL::type_list<Ts...>> {
+        using type = std::variant<Ts...>;
+    };
+
+    template<class Value, int... Ns>
+    std::vector<Value> make_closed_messages(std::integer_sequence<int, Ns...>) {
+        using factory = Value (*)(int);
+        constexpr factory factories[] = {[](int i) { return Value(message<Ns>{i}); }...};
+
+        std::vector<Value> values;
+        values.reserve(element_count);
+        for (std::size_t i = 0; i < element_count; ++i)
+            values.push_back(factories[(i * 7919) % sizeof...(Ns)](static_cast<int>(i)));
+        return values;
+    }
+
+    template<int N>
+    void bench_closed_set() {
+        using tl_variant = TL::variant<message_list<N>>;
+        using std_variant = typename std_variant_of<message_list<N>>::type;
+        auto payload = [](const auto &m) -> long { return m.payload; };
+
+        std::printf("    %d types: sizeof any %zu, std::variant %zu, TL::variant %zu\n",
+                    N, sizeof(any), sizeof(std_variant), sizeof(tl_variant));
+
+        std::vector<any> anys = make_messages(std::make_integer_sequence<int, N>{});
+        long any_sum = 0;
+        bench::measure("any: visit", element_count, [&] {
+            for (const any &value : anys)
+                any_sum += visit<message_list<N>>(value, payload, [](const any &) -> long { return -1; });
+        });
+        bench::keep(any_sum);
+
+        std::vector<std_variant> std_variants = make_closed_messages<std_variant>(std::make_integer_sequence<int, N>{});
+        long std_sum = 0;
+        bench::measure("std::variant: std::visit", element_count, [&] {
+            for (const std_variant &value : std_variants)
+                std_sum += std::visit(payload, value);
+        });
+        bench::keep(std_sum);
+
+        std::vector<tl_variant> tl_variants = make_closed_messages<tl_variant>(std::make_integer_sequence<int, N>{});
+        long tl_sum = 0;
+        bench::measure("TL::variant: visit", element_count, [&] {
+            for (const tl_variant &value : tl_variants)
+                tl_sum += value.visit(payload);
+        });
+        bench::keep(tl_sum);
+    }
+}
+
+BENCHMARK_CASE("closed set of 3/16/100 types: any vs std::variant vs TL::variant") {
+    bench_closed_set<3>();
+    bench_closed_set<16>();
+    bench_closed_set<100>();
+}
+
+namespace {
+    constexpr std::size_t pair_count = 1000000;
+
+    template<int A, int... Bs>
+    bool cast_chain_row(const any &a, const any &b, long &result) {
+        const message<A> *x = any_cast<message<A>>(&a);
+        return x != nullptr &&
+               ((any_cast<message<Bs>>(&b) != nullptr ? (result = x->payload * 16 + any_cast<message<Bs>>(&b)->payload, true) : false) || ...);
+    }
+
+    // tests every (A, B) pair in turn, as a hand written double dispatch would
+    template<int... Ns>
+    long cast_chain2(const any &a, const any &b, std::integer_sequence<int, Ns...>) {
+        long result = -1;
+        (cast_chain_row<Ns, Ns...>(a, b, result) || ...);
+        return result;
+    }
+}
+
+BENCHMARK_CASE("double dispatch over 16x16 type pairs: nested any_cast vs visit2") {
+    std::vector<any> lhs = make_messages(std::make_integer_sequence<int, 16>{});
+    std::vector<any> rhs = make_messages(std::make_integer_sequence<int, 16>{});
+    std::reverse(rhs.begin(), rhs.end());
+
+    long chain_sum = 0;
+    bench::measure("nested any_cast chains", pair_count, [&] {
+        for (std::size_t i = 0; i < pair_count; ++i)
+            chain_sum += cast_chain2(lhs[i], rhs[i], std::make_integer_sequence<int, 16>{});
+    });
+    bench::keep(chain_sum);
+
+    long visit_sum = 0;
+    bench::measure("visit2", pair_count, [&] {
+        for (std::size_t i = 0; i < pair_count; ++i) {
+            visit_sum += visit2<message_list<16>, message_list<16>>(lhs[i], rhs[i], [](const auto &x, const auto &y) -> long {
+                return x.payload * 16 + y.payload;
+            });
+        }
+    });
+    bench::keep(visit_sum);
+}
+
+namespace {
+    struct particle {
+        double position[3];
+        double velocity[3];
+        double mass;
+    };
+
+    template<typename Container>
+    void fill_mixed(Container &values) {
+        for (std::size_t i = 0; i < element_count; ++i) {
+            if (i % 3 == 0)
+                values.push_back(static_cast<int>(i));
+            else if (i % 3 == 1)
+                values.push_back(static_cast<double>(i));
+            else
+                values.push_back(particle{{0, 0, 0}, {1, 1, 1}, static_cast<double>(i)});
+        }
+    }
+}
+
+BENCHMARK_CASE("1M mixed int/double/particle: std::vector<any> vs any_vector") {
+    std::vector<any> anys;
+    anys.reserve(element_count);
+    fill_mixed(anys);
+
+    double any_mass = 0;
+    bench::measure("std::vector<any>: sum particle masses", element_count, [&] {
+        for (const any &value : anys) {
+            if (const particle *p = any_cast<particle>(&value))
+                any_mass += p->mass;
+        }
+    });
+    bench::keep(any_mass);
+
+    bench::measure("std::vector<any>: clear", element_count, [&] {
+        anys.clear();
+    });
+
+    // no reserve, the index and the segments grow geometrically
+    any_vector values;
+    bench::measure("any_vector: push_back without reserve", element_count, [&] {
+        fill_mixed(values);
+    });
+
+    double vector_mass = 0;
+    bench::measure("any_vector: for_each<particle>", element_count, [&] {
+        values.for_each<particle>([&](const particle &p) { vector_mass += p.mass; });
+    });
+    bench::keep(vector_mass);
+
+    bench::measure("any_vector: clear", element_count, [&] {
+        values.clear();
+    });
+}
+
+namespace {
+    using type_map = std::unordered_map<std::type_index, any>;
+
+    template<int... Ns>
+    void fill_properties(type_map &map, std::integer_sequence<int, Ns...>) {
+        (map.emplace(typeid(message<Ns>), message<Ns>{Ns}), ...);
+    }
+
+    template<int... Ns>
+    void fill_properties(any_map &map, std::integer_sequence<int, Ns...>) {
+        (map.emplace<message<Ns>>(message<Ns>{Ns}), ...);
+    }
+
+    template<int... Ns>
+    long read_properties(const type_map &map, std::integer_sequence<int, Ns...>) {
+        return (any_cast<const message<Ns> &>(map.find(typeid(message<Ns>))->second).payload + ...);
+    }
+
+    template<int... Ns>
+    long read_properties(const any_map &map, std::integer_sequence<int, Ns...>) {
+        return (map.get<message<Ns>>().payload + ...);
+    }
+}
+
+BENCHMARK_CASE("property bag of 6 types, 4 lookups: unordered_map<type_index, any> vs any_map") {
+    using stored = std::make_integer_sequence<int, 6>;
+    using looked_up = std::make_integer_sequence<int, 4>;
+
+    type_map types;
+    fill_properties(types, stored{});
+    long types_sum = 0;
+    bench::measure("unordered_map<type_index, any>: lookups", element_count, [&] {
+        for (std::size_t i = 0; i < element_count; ++i)
+            types_sum += read_properties(types, looked_up{});
+    });
+    bench::keep(types_sum);
+
+    any_map map;
+    fill_properties(map, stored{});
+    long map_sum = 0;
+    bench::measure("any_map: lookups", element_count, [&] {
+        for (std::size_t i = 0; i < element_count; ++i)
+            map_sum += read_properties(map, looked_up{});
+    });
+    bench::keep(map_sum);
+
+    constexpr std::size_t request_count = element_count / 10;
+
+    long types_built = 0;
+    bench::measure("unordered_map<type_index, any>: build, read and destroy", request_count, [&] {
+        for (std::size_t i = 0; i < request_count; ++i) {
+            type_map request;
+            fill_properties(request, stored{});
+            types_built += read_properties(request, looked_up{});
+        }
+    });
+    bench::keep(types_built);
+
+    long map_built = 0;
+    bench::measure("any_map: build, read and destroy", request_count, [&] {
+        for (std::size_t i = 0; i < request_count; ++i) {
+            any_map request;
+            fill_properties(request, stored{});
+            map_built += read_properties(request, looked_up{});
+        }
+    });
+    bench::keep(map_built);
+}
+
+namespace {
+    constexpr std::size_t fields_per_record = 5;
+
+    std::string render_field(std::size_t seed) {
+        return std::string(48, static_cast<char>('a' + seed % 26));
+    }
+}
+
+BENCHMARK_CASE("records of 5 string fields, 1 read: any vs lazy_any") {
+    constexpr std::size_t record_count = element_count / 10;
+
+    std::size_t eager_length = 0;
+    bench::measure("any: build every field", record_count, [&] {
+        for (std::size_t i = 0; i < record_count; ++i) {
+            any fields[fields_per_record];
+            for (std::size_t f = 0; f < fields_per_record; ++f)
+                fields[f] = render_field(i + f);
+            eager_length += any_cast<const std::string &>(fields[i % fields_per_record]).size();
+        }
+    });
+    bench::keep(eager_length);
+
+    std::size_t lazy_length = 0;
+    bench::measure("lazy_any: build the field read", record_count, [&] {
+        for (std::size_t i = 0; i < record_count; ++i) {
+            lazy_any fields[fields_per_record];
+            for (std::size_t f = 0; f < fields_per_record; ++f)
+                fields[f].defer<std::string>([seed = i + f] { return render_field(seed); });
+            lazy_length += any_cast<const std::string &>(fields[i % fields_per_record]).size();
+        }
+    });
+    bench::keep(lazy_length);
+}
+
+namespace {
+    struct large_payload {
+        double values[64];
+    };
+}
+
+BENCHMARK_CASE("1M construct/destroy of a 512 byte payload: any vs recycling_any") {
+    double any_sum = 0;
+    bench::measure("any", element_count, [&] {
+        for (std::size_t i = 0; i < element_count; ++i) {
+            any value(std::in_place_type<large_payload>);
+            any_sum += any_cast<large_payload &>(value).values[i % 64] += 1;
+        }
+    });
+    bench::keep(any_sum);
+
+    double recycling_sum = 0;
+    bench::measure("recycling_any", element_count, [&] {
+        for (std::size_t i = 0; i < element_count; ++i) {
+            recycling_any value(std::in_place_type<large_payload>);
+            recycling_sum += any_cast<large_payload &>(value).values[i % 64] += 1;
+        }
+    });
+    bench::keep(recycling_sum);
+    recycling_stats stats = recycling_allocator<large_payload>::stats();
+    std::printf("    recycling_any: %llu hits, %llu misses, hit rate %.4f\n", static_cast<unsigned long long>(stats.hits),
+                static_cast<unsigned long long>(stats.misses), stats.hit_rate());
+}
+
+BENCHMARK_CASE("requests of 1000 heap payloads: std::vector<any> vs anys in an any_arena") {
+    constexpr std::size_t payloads_per_request = 1000;
+    constexpr std::size_t request_count = element_count / payloads_per_request;
+
+    double heap_sum = 0;
+    bench::measure("std::vector<any>: build and destroy", element_count, [&] {
+        for (std::size_t r = 0; r < request_count; ++r) {
+            std::vector<any> values;
+            values.reserve(payloads_per_request);
+            for (std::size_t i = 0; i < payloads_per_request; ++i)
+                values.emplace_back(particle{{0, 0, 0}, {1, 1, 1}, static_cast<double>(i)});
+            heap_sum += any_cast<const particle &>(values[r % payloads_per_request]).mass;
+        }
+    });
+    bench::keep(heap_sum);
+
+    any_arena arena(payloads_per_request * (sizeof(particle) + sizeof(arena_any)) + 1024);
+    double vector_sum = 0;
+    bench::measure("std::vector<arena_any>: build, destroy and reset", element_count, [&] {
+        for (std::size_t r = 0; r < request_count; ++r) {
+            {
+                std::vector<arena_any> values;
+                values.reserve(payloads_per_request);
+                for (std::size_t i = 0; i < payloads_per_request; ++i)
+                    values.emplace_back(std::allocator_arg, arena, particle{{0, 0, 0}, {1, 1, 1}, static_cast<double>(i)});
+                vector_sum += any_cast<const particle &>(values[r % payloads_per_request]).mass;
+            }
+            arena.reset();
+        }
+    });
+    bench::keep(vector_sum);
+
+    double arena_sum = 0;
+    bench::measure("arena_any in the arena: build and reset", element_count, [&] {
+        for (std::size_t r = 0; r < request_count; ++r) {
+            const arena_any *read = nullptr;
+            for (std::size_t i = 0; i < payloads_per_request; ++i) {
+                arena_any &value = arena.make<arena_any>(particle{{0, 0, 0}, {1, 1, 1}, static_cast<double>(i)});
+                if (i == r % payloads_per_request)
+                    read = &value;
+            }
+            arena_sum += any_cast<const particle &>(*read).mass;
+            arena.reset();
+        }
+    });
+    bench::keep(arena_sum);
+}
@@ -0,0 +1,68 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+namespace bench {
+
+using case_function = void (*)();
+
+struct bench_case {
+    const char *name;
+    case_function function;
+};
+
+inline std::vector<bench_case> &registry() {
+    static std::vector<bench_case> cases;
+    return cases;
+}
+
+struct registrar {
+    registrar(const char *name, case_function function) {
+        registry().push_back({name, function});
+    }
+};
+
+#if !defined(__GNUC__)
+inline const void *volatile sink;
+#endif
+
+// keep a value observable so the optimizer cannot drop the work producing it;
+// the empty asm reads the value and clobbers memory, so it has to be computed
+template<typename T>
+void keep(const T &value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// run f once and print the average time per operation
+template<typename F>
+double measure(const char *label, std::size_t operations, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / operations;
+    std::printf("    %-56s %10.2f ns/op\n", label, ns);
+    return ns;
+}
+
+}
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+#define BENCHMARK_CASE(name) \
+    static void BENCH_CONCAT(bench_case_, __LINE__)(); \
+    static bench::registrar BENCH_CONCAT(bench_registrar_, __LINE__)(name, &BENCH_CONCAT(bench_case_, __LINE__)); \
+    static void BENCH_CONCAT(bench_case_, __LINE__)()
+
+#endif
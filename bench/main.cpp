@@ -0,0 +1,16 @@
+#include "bench/bench.hpp"
+
+#include <cstring>
+
+// runs every benchmark case, or only those whose name contains argv[1]
+int main(int argc, char **argv) {
+    for (const bench::bench_case &c : bench::registry()) {
+        if (argc > 1 && std::strstr(c.name, argv[1]) == nullptr)
+            continue;
+
+        std::printf("%s\n", c.name);
+        c.function();
+    }
+
+    return 0;
+}
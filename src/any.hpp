@@ -1,10 +1,51 @@
 #ifndef ANY_HPP
 #define ANY_HPP
 
+#include "relocation.hpp"
+#include "small_object_allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
 #include <type_traits>
 #include <typeinfo>
 #include <utility>
 
+// ANY_NO_RTTI replaces std::type_info with a compile-time type token so any can be built with -fno-rtti.
+// It is defined automatically when the compiler reports RTTI as disabled
+#if !defined(ANY_NO_RTTI) && !defined(__cpp_rtti) && !defined(__GXX_RTTI) && !defined(_CPPRTTI)
+#define ANY_NO_RTTI
+#endif
+
+// values of trivially copyable types without padding stored inline can be constant-initialized when the
+// compiler can copy their bytes during constant evaluation
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_bit_cast) && __has_builtin(__builtin_is_constant_evaluated)
+#define ANY_CONSTANT_INIT
+#endif
+#endif
+
+// ANY_INSTRUMENTATION counts per stored type how values are constructed, copied, moved and placed and how
+// many any_casts to the type fail. any_instrumentation::snapshot() returns the counts. Without it the
+// hooks expand to nothing
+#ifdef ANY_INSTRUMENTATION
+#include <atomic>
+#include <vector>
+
+#define ANY_INSTRUMENT(...) __VA_ARGS__
+#else
+#define ANY_INSTRUMENT(...)
+#endif
+
+// any_cast identifies the stored type by comparing vtable addresses and falls back to comparing type
+// identities, because a type can end up with one vtable per shared object. Define ANY_UNIQUE_VTABLES
+// to drop the fallback when no any crosses a shared object boundary
+
 class bad_any_cast : std::bad_cast {
 public:
     const char *what() const throw() override {
@@ -12,263 +53,1281 @@ public:
     }
 };
 
-class any {
+// the result of try_any_cast, a reference to the stored value or nothing when the any is empty or holds
+// another type
+template<class T>
+class any_cast_result {
+public:
+    constexpr any_cast_result(T *value) noexcept
+        : ptr(value)
+    {}
+
+    constexpr bool has_value() const noexcept {
+        return ptr != nullptr;
+    }
+
+    constexpr explicit operator bool() const noexcept {
+        return ptr != nullptr;
+    }
+
+    constexpr T &operator*() const noexcept {
+        return *ptr;
+    }
+
+    constexpr T *operator->() const noexcept {
+        return ptr;
+    }
+
+    template<class U>
+    constexpr std::remove_cv_t<T> value_or(U &&default_value) const {
+        return ptr != nullptr ? *ptr : static_cast<std::remove_cv_t<T>>(std::forward<U>(default_value));
+    }
+
+private:
+    T *ptr;
+};
+
+#ifndef ANY_NO_RTTI
+using any_type_info = std::type_info;
+
+template<class T>
+constexpr const any_type_info &any_type_id() noexcept {
+    return typeid(T);
+}
+#else
+class any_type_info {
 private:
-    union storage_union {
-        using stack_storage_t = typename std::aligned_storage<2*sizeof(void*), alignof(void*)>::type;
-        void *heap;
-        stack_storage_t stack;    
+    const char *(*signature)() noexcept;
+
+    constexpr explicit any_type_info(const char *(*signature)() noexcept) noexcept
+        : signature{signature}
+    {}
+
+    template<class T>
+    static const char *type_signature() noexcept {
+#if defined(_MSC_VER)
+        return __FUNCSIG__;
+#else
+        return __PRETTY_FUNCTION__;
+#endif
+    }
+
+    template<class T>
+    struct token {
+        static constexpr any_type_info value{&any_type_info::type_signature<T>};
     };
 
+    template<class T>
+    friend constexpr const any_type_info &any_type_id() noexcept;
+
+public:
+    any_type_info(const any_type_info &) = delete;
+    any_type_info &operator=(const any_type_info &) = delete;
+
+    // the signature of a function template specialized on the type, unique per type but not demangled
+    const char *name() const noexcept {
+        return signature();
+    }
+
+    bool operator==(const any_type_info &rhs) const noexcept {
+        return this == &rhs || std::strcmp(name(), rhs.name()) == 0;
+    }
+
+    bool operator!=(const any_type_info &rhs) const noexcept {
+        return !(*this == rhs);
+    }
+};
+
+template<class T>
+constexpr const any_type_info &any_type_id() noexcept {
+    return any_type_info::token<std::remove_cv_t<T>>::value;
+}
+#endif
+
+#ifdef ANY_INSTRUMENTATION
+namespace any_instrumentation {
+    using counter = std::atomic<std::uint64_t>;
+
+    struct type_counters {
+        const any_type_info *type;
+        counter constructions;
+        counter copies;
+        counter moves;
+        counter heap_allocations;
+        counter inline_placements;
+        counter bytes_allocated;
+        counter failed_casts;
+        std::atomic<bool> registered;
+        type_counters *next;
+
+        constexpr explicit type_counters(const any_type_info *type) noexcept
+            : type{type}, constructions{0}, copies{0}, moves{0}, heap_allocations{0}, inline_placements{0},
+              bytes_allocated{0}, failed_casts{0}, registered{false}, next{nullptr}
+        {}
+    };
+
+    // the counts of one type at the time of the snapshot
+    struct type_stats {
+        const any_type_info *type;
+        std::uint64_t constructions;
+        std::uint64_t copies;
+        std::uint64_t moves;
+        std::uint64_t heap_allocations;
+        std::uint64_t inline_placements;
+        std::uint64_t bytes_allocated;
+        std::uint64_t failed_casts;
+    };
+
+    // types are registered the first time one of their counters moves
+    inline std::atomic<type_counters *> registry{nullptr};
+
+    template<class T>
+    struct counters_holder {
+        static inline type_counters value{&any_type_id<T>()};
+    };
+
+    template<class T>
+    constexpr type_counters *counters() noexcept {
+        return &counters_holder<std::remove_cv_t<T>>::value;
+    }
+
+    inline void count(type_counters *counters, counter type_counters::*field, std::uint64_t n = 1) noexcept {
+        (counters->*field).fetch_add(n, std::memory_order_relaxed);
+
+        if (!counters->registered.load(std::memory_order_acquire) && !counters->registered.exchange(true)) {
+            counters->next = registry.load(std::memory_order_relaxed);
+            while (!registry.compare_exchange_weak(counters->next, counters, std::memory_order_release, std::memory_order_relaxed));
+        }
+    }
+
+    template<class T>
+    void count(counter type_counters::*field, std::uint64_t n = 1) noexcept {
+        count(counters<T>(), field, n);
+    }
+
+    inline std::vector<type_stats> snapshot() {
+        std::vector<type_stats> stats;
+        for (type_counters *c = registry.load(std::memory_order_acquire); c != nullptr; c = c->next) {
+            stats.push_back({c->type, c->constructions.load(std::memory_order_relaxed), c->copies.load(std::memory_order_relaxed),
+                             c->moves.load(std::memory_order_relaxed), c->heap_allocations.load(std::memory_order_relaxed),
+                             c->inline_placements.load(std::memory_order_relaxed), c->bytes_allocated.load(std::memory_order_relaxed),
+                             c->failed_casts.load(std::memory_order_relaxed)});
+        }
+
+        return stats;
+    }
+
+    // the counts of T, zero when no value of T was seen
+    template<class T>
+    type_stats stats_of() noexcept {
+        type_counters *c = counters<T>();
+        return {c->type, c->constructions.load(std::memory_order_relaxed), c->copies.load(std::memory_order_relaxed),
+                c->moves.load(std::memory_order_relaxed), c->heap_allocations.load(std::memory_order_relaxed),
+                c->inline_placements.load(std::memory_order_relaxed), c->bytes_allocated.load(std::memory_order_relaxed),
+                c->failed_casts.load(std::memory_order_relaxed)};
+    }
+
+    // sets every registered counter back to zero
+    inline void reset() noexcept {
+        for (type_counters *c = registry.load(std::memory_order_acquire); c != nullptr; c = c->next) {
+            for (counter type_counters::*field : {&type_counters::constructions, &type_counters::copies, &type_counters::moves,
+                                                  &type_counters::heap_allocations, &type_counters::inline_placements,
+                                                  &type_counters::bytes_allocated, &type_counters::failed_casts})
+                (c->*field).store(0, std::memory_order_relaxed);
+        }
+    }
+}
+#endif
+
+namespace any_secret {
+    // FNV-1a of the signature of a function template specialized on T. It is computed at compile time and equal
+    // in every shared object, so comparing it rules out most types before their identities are compared
+    template<class T>
+    constexpr std::uint64_t signature_hash() noexcept {
+#if defined(_MSC_VER)
+        const char *signature = __FUNCSIG__;
+#else
+        const char *signature = __PRETTY_FUNCTION__;
+#endif
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (; *signature != '\0'; ++signature)
+            hash = (hash ^ static_cast<unsigned char>(*signature)) * 0x100000001B3ull;
+        return hash;
+    }
+
+    template<class T>
+    struct type_hash {
+        static constexpr std::uint64_t value = signature_hash<std::remove_cv_t<T>>();
+    };
+
+    // true for the allocators of anys that keep only trivially relocatable values inline
+    template<class Alloc>
+    struct inline_relocatable_only : std::false_type {};
+
+    // whether ValueType can live in the inline buffer of a basic_any<InlineSize, InlineAlign, Alloc>
+    template<class ValueType, class Alloc = void>
+    constexpr bool fits_inline(std::size_t inline_size, std::size_t inline_align) noexcept {
+        return std::is_nothrow_move_constructible<ValueType>::value &&
+               sizeof(ValueType) <= inline_size &&
+               alignof(ValueType) <= inline_align &&
+               (!inline_relocatable_only<Alloc>::value || is_trivially_relocatable<ValueType>::value);
+    }
+
+    // vtables are shared by every basic_any instantiation, so the storage is passed as a raw pointer
+    // to the beginning of the storage_union. The heap pointer is always stored at offset 0.
+    // trivial values live inline and are copied, moved and destroyed by copying the buffer bytes.
+    // relocatable values, which include every heap value, are moved by copying the buffer bytes.
+    // trivially destructible values are dropped without calling destroy, which includes trivial values
+    // and heap values whose memory is released by someone else.
+    // Operations that allocate or free receive a pointer to the allocator of the any
     struct vtable_storage {
-        const std::type_info &(*type)() noexcept;
-        void (*move)(storage_union &src, storage_union &dest) noexcept;
-        void (*copy)(const storage_union &src, storage_union &dest);
-        void (*destroy)(storage_union &storage) noexcept;
+        const any_type_info *type;
+        std::uint64_t hash;
+        bool trivial;
+        bool relocatable;
+        bool trivially_destructible;
+        void (*move)(void *src, void *dest) noexcept;
+        void (*destroy)(void *storage, const void *allocator) noexcept;
+        const vtable_storage *(*convert)(void *src, void *dest, std::size_t inline_size, std::size_t inline_align,
+                                         const void *src_allocator, const void *dest_allocator);
+#ifdef ANY_INSTRUMENTATION
+        any_instrumentation::type_counters *counters;
+#endif
+    };
+
+    // move-only types get a vtable without the copy slot
+    struct copyable_vtable_storage : vtable_storage {
+        void (*copy)(const void *src, void *dest, const void *allocator);
     };
 
+#ifdef ANY_INSTRUMENTATION
+    using counters_t = any_instrumentation::type_counters;
+
+    inline void count(const vtable_storage *vtable, any_instrumentation::counter counters_t::*field) noexcept {
+        if (vtable != nullptr)
+            any_instrumentation::count(vtable->counters, field);
+    }
+#endif
+
     template<class ValueType>
+    using vtable_t = std::conditional_t<std::is_copy_constructible<ValueType>::value, copyable_vtable_storage, vtable_storage>;
+
+    template<class ValueType>
+    constexpr vtable_t<ValueType> make_vtable(bool trivial,
+                                              bool relocatable,
+                                              bool trivially_destructible,
+                                              decltype(vtable_storage::move) move,
+                                              decltype(copyable_vtable_storage::copy) copy,
+                                              decltype(vtable_storage::destroy) destroy,
+                                              decltype(vtable_storage::convert) convert) noexcept
+    {
+        vtable_storage vtable{&any_type_id<ValueType>(), type_hash<ValueType>::value, trivial, relocatable, trivially_destructible,
+                              move, destroy, convert
+                              ANY_INSTRUMENT(, any_instrumentation::counters<ValueType>())};
+        if constexpr (std::is_copy_constructible<ValueType>::value)
+            return copyable_vtable_storage{vtable, copy};
+        else
+            return vtable;
+    }
+
+    template<class Alloc>
+    bool allocators_equal(const Alloc &lhs, const Alloc &rhs) noexcept {
+        return std::allocator_traits<Alloc>::is_always_equal::value || lhs == rhs;
+    }
+
+    template<class ValueType, class Alloc>
+    struct vtable_stack;
+
+    template<class ValueType, class Alloc>
+    struct vtable_heap;
+
+    template<class ValueType, class Alloc>
     struct vtable_heap {
-        static const std::type_info &type() noexcept {
-            return typeid(ValueType);
+        using traits = typename std::allocator_traits<Alloc>::template rebind_traits<ValueType>;
+        using allocator_type = typename traits::allocator_type;
+
+        static ValueType *object(const void *storage) noexcept {
+            return *reinterpret_cast<ValueType *const *>(storage);
+        }
+
+        static const Alloc &allocator(const void *allocator) noexcept {
+            return *static_cast<const Alloc *>(allocator);
+        }
+
+        template<class... Args>
+        static ValueType *create(const Alloc &allocator, Args &&...args) {
+            allocator_type alloc(allocator);
+            ValueType *value = traits::allocate(alloc, 1);
+            try {
+                traits::construct(alloc, value, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                traits::deallocate(alloc, value, 1);
+                throw;
+            }
+
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::heap_allocations));
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::bytes_allocated, sizeof(ValueType)));
+            return value;
         }
 
-        static void move(storage_union &src, storage_union &dest) noexcept {
-            dest.heap = src.heap;
-            src.heap = nullptr;
+        static void release(const Alloc &allocator, ValueType *value) noexcept {
+            allocator_type alloc(allocator);
+            traits::destroy(alloc, value);
+            traits::deallocate(alloc, value, 1);
         }
 
-        static void copy(const storage_union &src, storage_union &dest) {
-            dest.heap = new ValueType(*reinterpret_cast<ValueType *>(src.heap));
+        static void move(void *src, void *dest) noexcept {
+            *reinterpret_cast<void **>(dest) = object(src);
+            *reinterpret_cast<void **>(src) = nullptr;
         }
 
-        static void destroy(storage_union &storage) noexcept {
-            delete reinterpret_cast<ValueType *>(storage.heap);
-            storage.heap = nullptr;
+        static void copy(const void *src, void *dest, const void *allocator) {
+            if constexpr (std::is_copy_constructible<ValueType>::value)
+                *reinterpret_cast<void **>(dest) = create(vtable_heap::allocator(allocator), *object(src));
+        }
+
+        static void destroy(void *storage, const void *allocator) noexcept {
+            release(vtable_heap::allocator(allocator), object(storage));
+            *reinterpret_cast<void **>(storage) = nullptr;
+        }
+
+        // called before the value is handed out for writing, heap values are never shared here
+        static void unshare(void *) noexcept {}
+
+        static bool exclusive(const void *) noexcept {
+            return true;
         }
+
+        static const vtable_storage *convert(void *src, void *dest, std::size_t inline_size, std::size_t inline_align,
+                                             const void *src_allocator, const void *dest_allocator)
+        {
+            if constexpr (std::is_nothrow_move_constructible<ValueType>::value) {
+                if (fits_inline<ValueType, Alloc>(inline_size, inline_align)) {
+                    new (dest) ValueType(std::move(*object(src)));
+                    ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::inline_placements));
+                    destroy(src, src_allocator);
+                    return &vtable_stack<ValueType, Alloc>::vtable;
+                }
+            }
+
+            if (allocators_equal(allocator(src_allocator), allocator(dest_allocator)))
+                move(src, dest);
+            else if constexpr (std::is_move_constructible<ValueType>::value) {
+                *reinterpret_cast<void **>(dest) = create(allocator(dest_allocator), std::move(*object(src)));
+                destroy(src, src_allocator);
+            }
+            else
+                throw std::logic_error("an immovable value cannot change allocator");
+
+            return &vtable;
+        }
+
+        static constexpr vtable_t<ValueType> vtable = make_vtable<ValueType>(false, true, false, move, copy, destroy, convert);
     };
 
-    template<class ValueType>
+    template<class ValueType, class Alloc>
     struct vtable_stack {
-        static const std::type_info &type() noexcept {
-            return typeid(ValueType);
+        static ValueType *object(const void *storage) noexcept {
+            return reinterpret_cast<ValueType *>(const_cast<void *>(storage));
         }
 
-        static void move(storage_union &src, storage_union &dest) noexcept {
-            new (&dest.stack) ValueType(std::move(*reinterpret_cast<ValueType*>(&src.stack)));
+        static void move(void *src, void *dest) noexcept {
+            new (dest) ValueType(std::move(*object(src)));
+            object(src)->~ValueType();
         }
 
-        static void copy(const storage_union &src, storage_union &dest) {
-            new (&dest.stack) ValueType(*reinterpret_cast<const ValueType*>(&src.stack));
+        static void copy(const void *src, void *dest, const void *) {
+            if constexpr (std::is_copy_constructible<ValueType>::value)
+                new (dest) ValueType(*object(src));
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::inline_placements));
         }
 
-        static void destroy(storage_union &storage) noexcept {
-            reinterpret_cast<ValueType *>(&storage.stack)->~ValueType();
+        static void destroy(void *storage, const void *) noexcept {
+            object(storage)->~ValueType();
         }
+
+        static const vtable_storage *convert(void *src, void *dest, std::size_t inline_size, std::size_t inline_align,
+                                             const void *, const void *dest_allocator)
+        {
+            if (fits_inline<ValueType, Alloc>(inline_size, inline_align)) {
+                move(src, dest);
+                return &vtable;
+            }
+
+            const Alloc &allocator = *static_cast<const Alloc *>(dest_allocator);
+            *reinterpret_cast<void **>(dest) = vtable_heap<ValueType, Alloc>::create(allocator, std::move(*object(src)));
+            object(src)->~ValueType();
+            return &vtable_heap<ValueType, Alloc>::vtable;
+        }
+
+        static constexpr bool trivial = std::is_trivially_copyable<ValueType>::value && std::is_trivially_destructible<ValueType>::value;
+
+        static constexpr vtable_t<ValueType> vtable = make_vtable<ValueType>(
+            trivial, trivial || is_trivially_relocatable<ValueType>::value, std::is_trivially_destructible<ValueType>::value,
+            move, copy, destroy, convert);
     };
 
+    // object representation of a value, used to place it in the inline buffer during constant evaluation
     template<class ValueType>
-    struct require_allocation : std::integral_constant<bool, 
-                                    !(std::is_nothrow_move_constructible<ValueType>::value &&
-                                      sizeof(ValueType) <= sizeof(storage_union::stack_storage_t) && 
-                                      std::alignment_of<ValueType>::value <= std::alignment_of<storage_union::stack_storage_t>::value)>
-    {};
+    struct object_bytes {
+        unsigned char data[sizeof(ValueType)];
+    };
 
-private:
-    vtable_storage *vtable;
-    storage_union storage;
-
-    template <class ValueType>
-    static vtable_storage *construct_vtable() {
-        using vtable_t = typename std::conditional<require_allocation<ValueType>::value, vtable_heap<ValueType>, vtable_stack<ValueType>>::type;
-
-        static vtable_storage storage {
-            vtable_t::type,
-            vtable_t::move,
-            vtable_t::copy,
-            vtable_t::destroy
+    // the padding bytes of other types are indeterminate and cannot be read during constant evaluation
+    template<class ValueType>
+    constexpr bool has_constant_bytes = std::is_trivially_copyable<ValueType>::value &&
+                                        (std::has_unique_object_representations<ValueType>::value ||
+                                         std::is_same<ValueType, float>::value || std::is_same<ValueType, double>::value);
+
+    // stateless allocators are default constructed on use and take no space in the any
+    template<class Alloc, bool = std::is_empty<Alloc>::value && std::is_default_constructible<Alloc>::value>
+    class allocator_holder {
+    protected:
+        constexpr allocator_holder() noexcept = default;
+
+        constexpr explicit allocator_holder(const Alloc &) noexcept {}
+
+        Alloc allocator() const noexcept {
+            return Alloc();
+        }
+    };
+
+    template<class Alloc>
+    class allocator_holder<Alloc, false> {
+    private:
+        Alloc alloc;
+
+    protected:
+        allocator_holder() noexcept(std::is_nothrow_default_constructible<Alloc>::value) = default;
+
+        explicit allocator_holder(const Alloc &alloc) noexcept
+            : alloc{alloc}
+        {}
+
+        const Alloc &allocator() const noexcept {
+            return alloc;
+        }
+    };
+
+    struct value_tag {};
+
+    struct any_access;
+
+    // storage, vtable handling and type queries shared by basic_any and basic_unique_any.
+    // Vtable is copyable_vtable_storage for the copyable flavour and vtable_storage for the move-only one.
+    // The allocator serves the heap path and is fixed at construction: move construction takes the
+    // allocator of the source, copy construction asks select_on_container_copy_construction and
+    // assignment keeps the allocator of the target
+    template<std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+    class any_storage : private allocator_holder<Alloc> {
+        static_assert(InlineSize >= sizeof(void*), "InlineSize shall be large enough to hold a pointer");
+        static_assert(InlineAlign >= alignof(void*), "InlineAlign shall be at least the alignment of a pointer");
+        static_assert((InlineAlign & (InlineAlign - 1)) == 0, "InlineAlign shall be a power of two");
+
+    protected:
+        union storage_union {
+            void *heap;
+            alignas(InlineAlign) unsigned char stack[InlineSize];
+
+            constexpr storage_union() noexcept : heap{nullptr} {}
+
+            template<std::size_t N, std::size_t... Is>
+            constexpr storage_union(const unsigned char (&bytes)[N], std::index_sequence<Is...>) noexcept
+                : stack{(Is < N ? bytes[Is] : static_cast<unsigned char>(0))...}
+            {}
         };
 
-        return &storage;
-    }
+        template<class ValueType>
+        struct require_allocation : std::integral_constant<bool,
+                                        !fits_inline<ValueType, Alloc>(InlineSize, InlineAlign)>
+        {};
 
-    template<class ValueType, class T>
-    std::enable_if_t<require_allocation<ValueType>::value>
-    construct_storage(ValueType &&val) {
-        storage.heap = new T(std::forward<ValueType>(val));            
-    }
+        using holder = allocator_holder<Alloc>;
+        using alloc_traits = std::allocator_traits<Alloc>;
 
-    template<class ValueType, class T>
-    std::enable_if_t<!require_allocation<ValueType>::value>
-    construct_storage(ValueType &&val) {
-        new (&storage.stack) T(std::forward<ValueType>(val));
-    }
+    protected:
+        const Vtable *vtable;
+        storage_union storage;
 
-    template<class ValueType>
-    ValueType *cast() noexcept {
-        return require_allocation<std::decay_t<ValueType>>::value ?
-                    reinterpret_cast<ValueType *>(storage.heap) :
-                    reinterpret_cast<ValueType *>(&storage.stack);
-    }
+        template <class ValueType>
+        static constexpr const Vtable *construct_vtable() noexcept {
+            using vtable_t = typename std::conditional<require_allocation<ValueType>::value, vtable_heap<ValueType, Alloc>, vtable_stack<ValueType, Alloc>>::type;
+            static_assert(std::is_convertible<decltype(&vtable_t::vtable), const Vtable *>::value,
+                          "ValueType shall satisfy the CopyConstructible requirements.");
+            return &vtable_t::vtable;
+        }
 
-    template<class ValueType>
-    const ValueType *cast() const noexcept {
-        return require_allocation<std::decay_t<ValueType>>::value ?
-                    reinterpret_cast<const ValueType *>(storage.heap) :
-                    reinterpret_cast<const ValueType *>(&storage.stack);
-    }
+        template<class ValueType, class T>
+        std::enable_if_t<require_allocation<T>::value>
+        construct_storage(ValueType &&val) {
+            storage.heap = vtable_heap<T, Alloc>::create(holder::allocator(), std::forward<ValueType>(val));
+            ANY_INSTRUMENT(any_instrumentation::count<T>(&counters_t::constructions));
+        }
 
-public:
-    template<class T>
-    friend T any_cast(const any &operand);
+        template<class ValueType, class T>
+        constexpr std::enable_if_t<!require_allocation<T>::value>
+        construct_storage(ValueType &&val) {
+#ifdef ANY_CONSTANT_INIT
+            if constexpr (has_constant_bytes<T>) {
+                if (__builtin_is_constant_evaluated()) {
+                    const T value(std::forward<ValueType>(val));
+                    storage = storage_union(__builtin_bit_cast(object_bytes<T>, value).data,
+                                            std::make_index_sequence<InlineSize>{});
+                    return;
+                }
+            }
+#endif
+            new (&storage.stack) T(std::forward<ValueType>(val));
+            ANY_INSTRUMENT(any_instrumentation::count<T>(&counters_t::constructions));
+            ANY_INSTRUMENT(any_instrumentation::count<T>(&counters_t::inline_placements));
+        }
 
+        // constructs a value of type ValueType from args in the empty storage
+        template<class ValueType, class... Args>
+        ValueType &construct_in_place(Args &&...args) {
+            if constexpr (require_allocation<ValueType>::value)
+                storage.heap = vtable_heap<ValueType, Alloc>::create(holder::allocator(), std::forward<Args>(args)...);
+            else {
+                new (&storage.stack) ValueType(std::forward<Args>(args)...);
+                ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::inline_placements));
+            }
+
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::constructions));
+            vtable = construct_vtable<ValueType>();
+            return *cast<ValueType>();
+        }
+
+        // gives the any its own copy of a heap value it may share before the value is written to
+        template<class ValueType>
+        static constexpr bool nothrow_unshare = std::is_const<ValueType>::value || !require_allocation<std::decay_t<ValueType>>::value ||
+                                                noexcept(vtable_heap<std::decay_t<ValueType>, Alloc>::unshare(nullptr));
+
+        template<class ValueType>
+        void unshare() noexcept(nothrow_unshare<ValueType>) {
+            if constexpr (require_allocation<std::decay_t<ValueType>>::value)
+                vtable_heap<std::decay_t<ValueType>, Alloc>::unshare(&storage);
+        }
+
+        // whether no other any shares the heap value of type ValueType
+        template<class ValueType>
+        bool exclusive() const noexcept {
+            if constexpr (require_allocation<std::decay_t<ValueType>>::value)
+                return vtable_heap<std::decay_t<ValueType>, Alloc>::exclusive(&storage);
+            else
+                return true;
+        }
+
+        // assigns value to the held value when it has the same type and is not shared, leaving the storage
+        // where it is. A shared value is replaced instead of copied only to be overwritten
+        template<class ValueType>
+        bool assign_in_place(ValueType &&value) {
+            using T = std::decay_t<ValueType>;
+            if constexpr (std::is_assignable<T &, ValueType>::value) {
+                if (vtable == construct_vtable<T>() && exclusive<T>()) {
+                    *cast<T>() = std::forward<ValueType>(value);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // empty or holding a trivial value, the storage can be copied and dropped as raw bytes
+        bool is_trivial() const noexcept {
+            return vtable == nullptr || vtable->trivial;
+        }
+
+        // empty or holding a relocatable value, the storage can be moved as raw bytes
+        bool is_relocatable() const noexcept {
+            return vtable == nullptr || vtable->relocatable;
+        }
+
+        // moves the value held by vtable from src to the empty dest, leaving src without a value
+        static void relocate(const vtable_storage *vtable, void *src, void *dest) noexcept {
+            if (vtable == nullptr || vtable->relocatable)
+                std::memcpy(dest, src, sizeof(storage_union));
+            else
+                vtable->move(src, dest);
+        }
+
+        // vtables are unique per type and storage kind, so the address comparison answers in the common case
+        template<class ValueType>
+        bool holds() const noexcept {
+            // the copyable flavour never stores a type it cannot copy
+            if constexpr (std::is_same<Vtable, copyable_vtable_storage>::value && !std::is_copy_constructible<ValueType>::value)
+                return false;
+            else {
+                const vtable_storage *expected = construct_vtable<std::remove_cv_t<ValueType>>();
+                if (vtable == expected)
+                    return true;
+
+#ifndef ANY_UNIQUE_VTABLES
+                return vtable != nullptr && *vtable->type == any_type_id<ValueType>();
+#else
+                return false;
+#endif
+            }
+        }
+
+        template<class ValueType>
+        ValueType *cast() noexcept {
+            return require_allocation<std::decay_t<ValueType>>::value ?
+                        reinterpret_cast<ValueType *>(storage.heap) :
+                        reinterpret_cast<ValueType *>(&storage.stack);
+        }
+
+        template<class ValueType>
+        const ValueType *cast() const noexcept {
+            return require_allocation<std::decay_t<ValueType>>::value ?
+                        reinterpret_cast<const ValueType *>(storage.heap) :
+                        reinterpret_cast<const ValueType *>(&storage.stack);
+        }
+
+        // takes the value of other, whose storage is left empty
+        template<std::size_t OtherSize, std::size_t OtherAlign, class OtherVtable>
+        void take(any_storage<OtherSize, OtherAlign, OtherVtable, Alloc> &other) {
+            if (!other.has_value())
+                return;
+
+            ANY_INSTRUMENT(count(other.vtable, &counters_t::moves));
+            const Alloc &src_alloc = other.holder::allocator();
+            const Alloc &dest_alloc = holder::allocator();
+
+            if constexpr (OtherSize == InlineSize && OtherAlign == InlineAlign) {
+                if (other.is_trivial()) {
+                    std::memcpy(static_cast<void *>(&storage), static_cast<const void *>(&other.storage), sizeof(storage));
+                    other.vtable = nullptr;
+                    return;
+                }
+
+                if (allocators_equal(src_alloc, dest_alloc)) {
+                    relocate(other.vtable, &other.storage, &storage);
+                    other.vtable = nullptr;
+                    return;
+                }
+            }
+
+            vtable = static_cast<const Vtable *>(other.vtable->convert(&other.storage, &storage, InlineSize, InlineAlign,
+                                                                       &src_alloc, &dest_alloc));
+            other.vtable = nullptr;
+        }
+
+        // values that cannot be relocated bitwise are moved through a temporary buffer
+        void swap_storage(any_storage &other) noexcept {
+            if (is_relocatable() && other.is_relocatable())
+                std::swap(storage, other.storage);
+            else {
+                storage_union tmp;
+                relocate(other.vtable, &other.storage, &tmp);
+                relocate(vtable, &storage, &other.storage);
+                relocate(other.vtable, &tmp, &storage);
+            }
+
+            std::swap(vtable, other.vtable);
+        }
+
+        template<std::size_t OtherSize, std::size_t OtherAlign, class OtherVtable, class OtherAlloc>
+        friend class any_storage;
+
+        friend struct any_access;
+
+    protected:
+        constexpr any_storage() noexcept(std::is_nothrow_default_constructible<Alloc>::value)
+            : vtable{nullptr}, storage{}
+        {}
+
+        constexpr explicit any_storage(const Alloc &alloc) noexcept
+            : holder(alloc), vtable{nullptr}, storage{}
+        {}
+
+        template<class ValueType>
+        constexpr any_storage(value_tag, ValueType &&value)
+            : vtable{construct_vtable<std::decay_t<ValueType>>()}, storage{}
+        {
+            construct_storage<ValueType, std::decay_t<ValueType>>(std::forward<ValueType>(value));
+        }
+
+        template<class ValueType>
+        constexpr any_storage(value_tag, const Alloc &alloc, ValueType &&value)
+            : holder(alloc), vtable{construct_vtable<std::decay_t<ValueType>>()}, storage{}
+        {
+            construct_storage<ValueType, std::decay_t<ValueType>>(std::forward<ValueType>(value));
+        }
+
+        template<class ValueType, class... Args>
+        explicit any_storage(std::in_place_type_t<ValueType>, Args &&...args)
+            : vtable{nullptr}, storage{}
+        {
+            construct_in_place<ValueType>(std::forward<Args>(args)...);
+        }
+
+        template<class ValueType, class... Args>
+        any_storage(std::in_place_type_t<ValueType>, const Alloc &alloc, Args &&...args)
+            : holder(alloc), vtable{nullptr}, storage{}
+        {
+            construct_in_place<ValueType>(std::forward<Args>(args)...);
+        }
+
+        any_storage(const any_storage &other, const Alloc &alloc)
+            : holder(alloc), vtable{other.vtable}, storage{other.storage}
+        {
+            ANY_INSTRUMENT(count(vtable, &counters_t::copies));
+            ANY_INSTRUMENT(if (vtable != nullptr && vtable->trivial) count(vtable, &counters_t::inline_placements));
+            if (!is_trivial()) {
+                const Alloc &dest_alloc = holder::allocator();
+                vtable->copy(&other.storage, &storage, &dest_alloc);
+            }
+        }
+
+        any_storage(const any_storage &other)
+            : any_storage(other, alloc_traits::select_on_container_copy_construction(other.holder::allocator()))
+        {}
+
+        any_storage(any_storage &&other) noexcept
+            : holder(other.holder::allocator()), vtable{other.vtable}, storage{other.storage}
+        {
+            ANY_INSTRUMENT(count(vtable, &counters_t::moves));
+            if (!is_relocatable())
+                vtable->move(&other.storage, &storage);
+            other.vtable = nullptr;
+        }
+
+        any_storage(any_storage &&other, const Alloc &alloc)
+            : holder(alloc), vtable{other.vtable}
+        {
+            take(other);
+        }
+
+        // conversion from an instantiation with a different inline buffer. Values that fit inline in both
+        // are moved from buffer to buffer, heap values that still do not fit keep their allocation
+        template<std::size_t OtherSize, std::size_t OtherAlign, class OtherVtable>
+        any_storage(any_storage<OtherSize, OtherAlign, OtherVtable, Alloc> &&other)
+            : holder(other.holder::allocator()), vtable{other.vtable}
+        {
+            take(other);
+        }
+
+        any_storage &operator=(const any_storage &rhs) {
+            if (is_trivial() && rhs.is_trivial()) {
+                ANY_INSTRUMENT(count(rhs.vtable, &counters_t::copies));
+                ANY_INSTRUMENT(count(rhs.vtable, &counters_t::inline_placements));
+                vtable = rhs.vtable;
+                storage = rhs.storage;
+                return *this;
+            }
+
+            if (&rhs == this)
+                return *this;
+
+            any_storage(rhs, holder::allocator()).swap_storage(*this);
+            return *this;
+        }
+
+        // only an allocator that may differ from the one of rhs forces a reallocation
+        any_storage &operator=(any_storage &&rhs) noexcept(alloc_traits::is_always_equal::value) {
+            if (&rhs == this)
+                return *this;
+
+            if (is_trivial() && rhs.is_trivial()) {
+                ANY_INSTRUMENT(count(rhs.vtable, &counters_t::moves));
+                vtable = rhs.vtable;
+                storage = rhs.storage;
+                rhs.vtable = nullptr;
+                return *this;
+            }
+
+            any_storage(std::move(rhs), holder::allocator()).swap_storage(*this);
+            return *this;
+        }
+
+        ~any_storage() {
+            reset();
+        }
+
+        // anys with unequal allocators exchange their values by moving them into each other's allocations
+        void swap(any_storage &other) noexcept(alloc_traits::is_always_equal::value) {
+            if (&other == this)
+                return;
+
+            if (allocators_equal(holder::allocator(), other.holder::allocator())) {
+                swap_storage(other);
+                return;
+            }
+
+            any_storage tmp(std::move(other), other.holder::allocator());
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+    public:
+        using allocator_type = Alloc;
+
+        static constexpr std::size_t inline_size = InlineSize;
+        static constexpr std::size_t inline_align = InlineAlign;
+
+        // true if ValueType is stored in the inline buffer instead of being allocated on the heap
+        template<class ValueType>
+        static constexpr bool is_stored_inline = !require_allocation<std::decay_t<ValueType>>::value;
+
+        allocator_type get_allocator() const noexcept {
+            return holder::allocator();
+        }
+
+        const any_type_info &type() const noexcept {
+            if (has_value())
+                return *vtable->type;
+            return any_type_id<void>();
+        }
+
+        bool has_value() const noexcept {
+            return vtable != nullptr;
+        }
+
+        void reset() noexcept {
+            if (vtable != nullptr && !vtable->trivially_destructible) {
+                const Alloc &alloc = holder::allocator();
+                vtable->destroy(&storage, &alloc);
+            }
+            vtable = nullptr;
+        }
+
+        // replaces the value by one constructed from args directly in the inline buffer or the heap block.
+        // The any is left empty when the construction throws
+        template<class ValueType, class... Args>
+        std::decay_t<ValueType> &emplace(Args &&...args) {
+            reset();
+            return construct_in_place<std::decay_t<ValueType>>(std::forward<Args>(args)...);
+        }
+
+        template<class ValueType, class U, class... Args>
+        std::decay_t<ValueType> &emplace(std::initializer_list<U> il, Args &&...args) {
+            reset();
+            return construct_in_place<std::decay_t<ValueType>>(il, std::forward<Args>(args)...);
+        }
+    };
+
+    // gives the any_cast family access to the storage of every any flavour
+    struct any_access {
+        template<class T, std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+        static const T *cast(const any_storage<InlineSize, InlineAlign, Vtable, Alloc> *operand) noexcept {
+            if (operand == nullptr || !operand->template holds<T>()) {
+                ANY_INSTRUMENT(if (operand != nullptr) any_instrumentation::count<T>(&counters_t::failed_casts));
+                return nullptr;
+            }
+
+            return operand->template cast<T>();
+        }
+
+        // a const target only reads the value, so a shared value is not copied
+        template<class T, std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+        static T *cast(any_storage<InlineSize, InlineAlign, Vtable, Alloc> *operand)
+            noexcept(any_storage<InlineSize, InlineAlign, Vtable, Alloc>::template nothrow_unshare<T>)
+        {
+            if constexpr (std::is_const<T>::value)
+                return cast<T>(static_cast<const any_storage<InlineSize, InlineAlign, Vtable, Alloc> *>(operand));
+            else {
+                if (operand == nullptr || !operand->template holds<T>()) {
+                    ANY_INSTRUMENT(if (operand != nullptr) any_instrumentation::count<T>(&counters_t::failed_casts));
+                    return nullptr;
+                }
+
+                operand->template unshare<T>();
+                return operand->template cast<T>();
+            }
+        }
+
+        // for callers that already know the stored type, such as visit
+        template<class T, std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+        static const T *unchecked_cast(const any_storage<InlineSize, InlineAlign, Vtable, Alloc> *operand) noexcept {
+            return operand->template cast<T>();
+        }
+
+        template<class T, std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+        static T *unchecked_cast(any_storage<InlineSize, InlineAlign, Vtable, Alloc> *operand)
+            noexcept(any_storage<InlineSize, InlineAlign, Vtable, Alloc>::template nothrow_unshare<T>)
+        {
+            operand->template unshare<T>();
+            return operand->template cast<T>();
+        }
+
+        template<std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+        static const vtable_storage *vtable(const any_storage<InlineSize, InlineAlign, Vtable, Alloc> &operand) noexcept {
+            return operand.vtable;
+        }
+
+        // the vtable a value of type T gets in the storage type Storage
+        template<class T, class Storage>
+        static constexpr const vtable_storage *vtable_for() noexcept {
+            return Storage::template construct_vtable<T>();
+        }
+    };
+
+    template<std::size_t InlineSize, std::size_t InlineAlign, class Vtable, class Alloc>
+    std::true_type is_any_storage_test(const any_storage<InlineSize, InlineAlign, Vtable, Alloc> *);
+
+    std::false_type is_any_storage_test(const void *);
+
+    // true for every any flavour, which are never stored as values of another one
     template<class T>
-    friend T any_cast(any &operand);
+    struct is_any_storage : decltype(is_any_storage_test(std::declval<T *>())) {};
 
     template<class T>
-    friend T any_cast(any &&operand);
+    struct is_in_place_type : std::false_type {};
 
     template<class T>
-    friend const T *any_cast(const any *operand) noexcept;
+    struct is_in_place_type<std::in_place_type_t<T>> : std::true_type {};
 
+    // what the forwarding constructors accept as a value
     template<class T>
-    friend T *any_cast(any *operand) noexcept;
+    constexpr bool is_value_v = !is_any_storage<T>::value && !is_in_place_type<T>::value;
+}
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc = small_object_allocator<std::byte>>
+class basic_any : public any_secret::any_storage<InlineSize, InlineAlign, any_secret::copyable_vtable_storage, Alloc> {
+private:
+    using base = any_secret::any_storage<InlineSize, InlineAlign, any_secret::copyable_vtable_storage, Alloc>;
 
 public:
-    any() noexcept : vtable{nullptr} {}
+    constexpr basic_any() noexcept(std::is_nothrow_default_constructible<Alloc>::value) = default;
 
-    any(const any &other) {
-        if (other.has_value())
-            other.vtable->copy(other.storage, storage);
-        vtable = other.vtable;
-    }
+    constexpr basic_any(std::allocator_arg_t, const Alloc &alloc) noexcept
+        : base(alloc)
+    {}
 
-    any(any &&other) {
-        if (other.has_value())
-            other.vtable->move(other.storage, storage);
-        vtable = other.vtable;
-        other.vtable = nullptr;
-    }
+    basic_any(const basic_any &other) = default;
 
-    template<class ValueType, 
-             typename std::enable_if_t<!std::is_same<std::decay_t<ValueType>, any>::value, int> = 0>
-    any(ValueType &&value) {
-        static_assert(std::is_copy_constructible_v<std::decay_t<ValueType>>, "ValueType shall satisfy the CopyConstructible requirements.");
-        vtable = construct_vtable<std::decay_t<ValueType>>();
-        construct_storage<ValueType, std::decay_t<ValueType>>(std::forward<ValueType>(value));
-    }
+    basic_any(std::allocator_arg_t, const Alloc &alloc, const basic_any &other)
+        : base(other, alloc)
+    {}
 
-    any &operator=(const any &rhs) {
-        if (&rhs == this)
-            return *this;
-        
-        any(rhs).swap(*this);
-        return *this;
-    }
+    basic_any(basic_any &&other) = default;
 
-    any &operator=(any &&rhs) {
-        if (&rhs == this)
-            return *this;
+    basic_any(std::allocator_arg_t, const Alloc &alloc, basic_any &&other)
+        : base(std::move(other), alloc)
+    {}
 
-        any(std::move(rhs)).swap(*this);
-        return *this;
-    }
+    template<std::size_t OtherSize, std::size_t OtherAlign>
+    basic_any(basic_any<OtherSize, OtherAlign, Alloc> &&other)
+        : base(std::move(other))
+    {}
+
+    template<std::size_t OtherSize, std::size_t OtherAlign>
+    basic_any(const basic_any<OtherSize, OtherAlign, Alloc> &other)
+        : basic_any(basic_any<OtherSize, OtherAlign, Alloc>(other))
+    {}
+
+    // constant-initializes for empty values and trivially copyable values without padding stored inline
+    template<class ValueType,
+             typename std::enable_if_t<any_secret::is_value_v<std::decay_t<ValueType>>, int> = 0>
+    constexpr basic_any(ValueType &&value)
+        : base(any_secret::value_tag{}, std::forward<ValueType>(value))
+    {}
 
     template<class ValueType,
-             typename std::enable_if_t<!std::is_same_v<std::decay_t<ValueType>, any>, int> = 0>
-    any &operator=(ValueType &&rhs) {
-        any(std::forward<ValueType>(rhs)).swap(*this);
+             typename std::enable_if_t<any_secret::is_value_v<std::decay_t<ValueType>>, int> = 0>
+    basic_any(std::allocator_arg_t, const Alloc &alloc, ValueType &&value)
+        : base(any_secret::value_tag{}, alloc, std::forward<ValueType>(value))
+    {}
+
+    // the value is constructed from args where it is stored, without a temporary
+    template<class ValueType, class... Args>
+    explicit basic_any(std::in_place_type_t<ValueType>, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, std::forward<Args>(args)...)
+    {}
+
+    template<class ValueType, class U, class... Args>
+    explicit basic_any(std::in_place_type_t<ValueType>, std::initializer_list<U> il, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, il, std::forward<Args>(args)...)
+    {}
+
+    template<class ValueType, class... Args>
+    basic_any(std::allocator_arg_t, const Alloc &alloc, std::in_place_type_t<ValueType>, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, alloc, std::forward<Args>(args)...)
+    {}
+
+    template<class ValueType, class U, class... Args>
+    basic_any(std::allocator_arg_t, const Alloc &alloc, std::in_place_type_t<ValueType>, std::initializer_list<U> il, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, alloc, il, std::forward<Args>(args)...)
+    {}
+
+    basic_any &operator=(const basic_any &rhs) = default;
+
+    basic_any &operator=(basic_any &&rhs) = default;
+
+    template<class ValueType,
+             typename std::enable_if_t<any_secret::is_value_v<std::decay_t<ValueType>>, int> = 0>
+    basic_any &operator=(ValueType &&rhs) {
+        if (!this->assign_in_place(std::forward<ValueType>(rhs)))
+            basic_any(std::allocator_arg, this->get_allocator(), std::forward<ValueType>(rhs)).swap_storage(*this);
         return *this;
     }
 
-    ~any() {
-        reset();
+    void swap(basic_any &other) noexcept(std::allocator_traits<Alloc>::is_always_equal::value) {
+        base::swap(other);
     }
+};
+
+// move-only sibling of basic_any, accepts types that cannot be copied
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc = small_object_allocator<std::byte>>
+class basic_unique_any : public any_secret::any_storage<InlineSize, InlineAlign, any_secret::vtable_storage, Alloc> {
+private:
+    using base = any_secret::any_storage<InlineSize, InlineAlign, any_secret::vtable_storage, Alloc>;
 
-    const std::type_info &type() const noexcept {
-        if (has_value())
-            return vtable->type();
-        return typeid(void);
+public:
+    constexpr basic_unique_any() noexcept(std::is_nothrow_default_constructible<Alloc>::value) = default;
+
+    constexpr basic_unique_any(std::allocator_arg_t, const Alloc &alloc) noexcept
+        : base(alloc)
+    {}
+
+    basic_unique_any(const basic_unique_any &other) = delete;
+
+    basic_unique_any(basic_unique_any &&other) = default;
+
+    basic_unique_any(std::allocator_arg_t, const Alloc &alloc, basic_unique_any &&other)
+        : base(std::move(other), alloc)
+    {}
+
+    template<std::size_t OtherSize, std::size_t OtherAlign>
+    basic_unique_any(basic_unique_any<OtherSize, OtherAlign, Alloc> &&other)
+        : base(std::move(other))
+    {}
+
+    // a copyable any hands its value over, the vtable is shared so no conversion is needed
+    template<std::size_t OtherSize, std::size_t OtherAlign>
+    basic_unique_any(basic_any<OtherSize, OtherAlign, Alloc> &&other)
+        : base(std::move(other))
+    {}
+
+    template<class ValueType,
+             typename std::enable_if_t<any_secret::is_value_v<std::decay_t<ValueType>>, int> = 0>
+    constexpr basic_unique_any(ValueType &&value)
+        : base(any_secret::value_tag{}, std::forward<ValueType>(value))
+    {
+        static_assert(std::is_constructible_v<std::decay_t<ValueType>, ValueType>, "ValueType shall be constructible from value.");
     }
 
-    bool has_value() const noexcept {
-        return vtable != nullptr;
+    template<class ValueType,
+             typename std::enable_if_t<any_secret::is_value_v<std::decay_t<ValueType>>, int> = 0>
+    basic_unique_any(std::allocator_arg_t, const Alloc &alloc, ValueType &&value)
+        : base(any_secret::value_tag{}, alloc, std::forward<ValueType>(value))
+    {
+        static_assert(std::is_constructible_v<std::decay_t<ValueType>, ValueType>, "ValueType shall be constructible from value.");
     }
 
-    void reset() noexcept {
-        if (!has_value())
-            return;
-        
-        vtable->destroy(storage);
-        vtable = nullptr;
+    // also accepts types that can be neither copied nor moved, they are stored on the heap
+    template<class ValueType, class... Args>
+    explicit basic_unique_any(std::in_place_type_t<ValueType>, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, std::forward<Args>(args)...)
+    {}
+
+    template<class ValueType, class U, class... Args>
+    explicit basic_unique_any(std::in_place_type_t<ValueType>, std::initializer_list<U> il, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, il, std::forward<Args>(args)...)
+    {}
+
+    template<class ValueType, class... Args>
+    basic_unique_any(std::allocator_arg_t, const Alloc &alloc, std::in_place_type_t<ValueType>, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, alloc, std::forward<Args>(args)...)
+    {}
+
+    template<class ValueType, class U, class... Args>
+    basic_unique_any(std::allocator_arg_t, const Alloc &alloc, std::in_place_type_t<ValueType>, std::initializer_list<U> il, Args &&...args)
+        : base(std::in_place_type<std::decay_t<ValueType>>, alloc, il, std::forward<Args>(args)...)
+    {}
+
+    basic_unique_any &operator=(const basic_unique_any &rhs) = delete;
+
+    basic_unique_any &operator=(basic_unique_any &&rhs) = default;
+
+    template<class ValueType,
+             typename std::enable_if_t<any_secret::is_value_v<std::decay_t<ValueType>>, int> = 0>
+    basic_unique_any &operator=(ValueType &&rhs) {
+        if (!this->assign_in_place(std::forward<ValueType>(rhs)))
+            basic_unique_any(std::allocator_arg, this->get_allocator(), std::forward<ValueType>(rhs)).swap_storage(*this);
+        return *this;
     }
 
-    void swap(any &other) noexcept {
-        if (&other == this)
-            return;
-        
-        std::swap(vtable, other.vtable);
-        std::swap(storage, other.storage);
+    void swap(basic_unique_any &other) noexcept(std::allocator_traits<Alloc>::is_always_equal::value) {
+        base::swap(other);
     }
 };
 
-template<class T>
-T any_cast(const any &operand) {
+using any = basic_any<2*sizeof(void*), alignof(void*)>;
+
+using unique_any = basic_unique_any<2*sizeof(void*), alignof(void*)>;
+
+// selects the relocatable flavour of basic_any, allocations are made with Alloc
+template<class Alloc>
+class relocatable_allocator : public Alloc {
+public:
+    template<class U>
+    struct rebind {
+        using other = relocatable_allocator<typename std::allocator_traits<Alloc>::template rebind_alloc<U>>;
+    };
+
+    using Alloc::Alloc;
+
+    relocatable_allocator() = default;
+
+    relocatable_allocator(const Alloc &alloc) noexcept
+        : Alloc(alloc)
+    {}
+
+    template<class OtherAlloc>
+    relocatable_allocator(const relocatable_allocator<OtherAlloc> &alloc) noexcept
+        : Alloc(static_cast<const OtherAlloc &>(alloc))
+    {}
+};
+
+template<class Alloc>
+struct any_secret::inline_relocatable_only<relocatable_allocator<Alloc>> : std::true_type {};
+
+// anys that keep only trivially relocatable values inline and put the others on the heap, so the any itself
+// can be relocated by copying its bytes, for example by relocating_vector with realloc
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc = small_object_allocator<std::byte>>
+using basic_relocatable_any = basic_any<InlineSize, InlineAlign, relocatable_allocator<Alloc>>;
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc = small_object_allocator<std::byte>>
+using basic_relocatable_unique_any = basic_unique_any<InlineSize, InlineAlign, relocatable_allocator<Alloc>>;
+
+using relocatable_any = basic_relocatable_any<2*sizeof(void*), alignof(void*)>;
+
+using relocatable_unique_any = basic_relocatable_unique_any<2*sizeof(void*), alignof(void*)>;
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc>
+struct is_trivially_relocatable<basic_any<InlineSize, InlineAlign, relocatable_allocator<Alloc>>>
+    : is_trivially_relocatable<Alloc> {};
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc>
+struct is_trivially_relocatable<basic_unique_any<InlineSize, InlineAlign, relocatable_allocator<Alloc>>>
+    : is_trivially_relocatable<Alloc> {};
+
+// anys whose inline buffer holds a value of up to Align bytes aligned to Align, such as an __m256 or a cache
+// line. Larger or more aligned values go to the heap, which allocates with the alignment of the value
+template<std::size_t Align>
+using aligned_any = basic_any<Align, Align>;
+
+template<std::size_t Align>
+using aligned_unique_any = basic_unique_any<Align, Align>;
+
+// anys whose heap path allocates from a std::pmr::memory_resource
+namespace pmr {
+    template<std::size_t InlineSize, std::size_t InlineAlign>
+    using basic_any = ::basic_any<InlineSize, InlineAlign, std::pmr::polymorphic_allocator<std::byte>>;
+
+    template<std::size_t InlineSize, std::size_t InlineAlign>
+    using basic_unique_any = ::basic_unique_any<InlineSize, InlineAlign, std::pmr::polymorphic_allocator<std::byte>>;
+
+    using any = basic_any<2*sizeof(void*), alignof(void*)>;
+
+    using unique_any = basic_unique_any<2*sizeof(void*), alignof(void*)>;
+
+    template<std::size_t Align>
+    using aligned_any = basic_any<Align, Align>;
+
+    template<std::size_t Align>
+    using aligned_unique_any = basic_unique_any<Align, Align>;
+}
+
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+const T *any_cast(const any_secret::any_storage<Size, Align, Vtable, Alloc> *operand) noexcept {
+    return any_secret::any_access::cast<T>(operand);
+}
+
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+T *any_cast(any_secret::any_storage<Size, Align, Vtable, Alloc> *operand) noexcept(noexcept(any_secret::any_access::cast<T>(operand))) {
+    return any_secret::any_access::cast<T>(operand);
+}
+
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+T any_cast(const any_secret::any_storage<Size, Align, Vtable, Alloc> &operand) {
     using U = std::remove_cv_t<std::remove_reference_t<T>>;
-    static_assert(std::is_constructible_v<T, const U&>, 
+    static_assert(std::is_constructible_v<T, const U&>,
                   "Let U = std::remove_cv_t<std::remove_reference_t<T>>. The program is ill-formed if std::is_constructible_v<T, const U&> is false");
 
-    if (operand.type() != typeid(T))
+    auto ptr = any_cast<U>(&operand);
+    if (ptr == nullptr)
         throw bad_any_cast();
-    
-    return static_cast<T>(*any_cast<U>(&operand));
+
+    return static_cast<T>(*ptr);
 }
 
-template<class T>
-T any_cast(any &operand) {
+// a const reference or a copy only reads the value, so it goes through the const overload and a shared
+// value is not copied first
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+T any_cast(any_secret::any_storage<Size, Align, Vtable, Alloc> &operand) {
     using U = std::remove_cv_t<std::remove_reference_t<T>>;
-    static_assert(std::is_constructible_v<T, U&>, 
+    static_assert(std::is_constructible_v<T, U&>,
                   "Let U = std::remove_cv_t<std::remove_reference_t<T>>. The program is ill-formed if std::is_constructible_v<T, U&> is false");
 
-    if (operand.type() != typeid(T))
-        throw bad_any_cast();
+    if constexpr (std::is_const_v<std::remove_reference_t<T>> ||
+                  (!std::is_reference_v<T> && std::is_constructible_v<T, const U&>))
+        return any_cast<T>(std::as_const(operand));
+    else {
+        auto ptr = any_cast<U>(&operand);
+        if (ptr == nullptr)
+            throw bad_any_cast();
 
-    return static_cast<T>(*any_cast<U>(&operand));
+        return static_cast<T>(*ptr);
+    }
 }
 
-template<class T>
-T any_cast(any &&operand) {
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+T any_cast(any_secret::any_storage<Size, Align, Vtable, Alloc> &&operand) {
     using U = std::remove_cv_t<std::remove_reference_t<T>>;
-    static_assert(std::is_constructible_v<T, U>, 
+    static_assert(std::is_constructible_v<T, U>,
                   "Let U = std::remove_cv_t<std::remove_reference_t<T>>. The program is ill-formed if std::is_constructible_v<T, U> is false");
 
-    if (operand.type() != typeid(T))
+    auto ptr = any_cast<U>(&operand);
+    if (ptr == nullptr)
         throw bad_any_cast();
 
-    return static_cast<T>(std::move(*any_cast<U>(&operand)));
+    return static_cast<T>(std::move(*ptr));
 }
 
-template<class T>
-const T *any_cast(const any *operand) noexcept {
-    if (operand == nullptr || operand->type() != typeid(T))
-        return nullptr;
+// checks the type like the pointer any_cast and never throws bad_any_cast
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+any_cast_result<const T> try_any_cast(const any_secret::any_storage<Size, Align, Vtable, Alloc> &operand) noexcept {
+    return any_secret::any_access::cast<T>(&operand);
+}
 
-    return operand->cast<T>();
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+any_cast_result<T> try_any_cast(any_secret::any_storage<Size, Align, Vtable, Alloc> &operand) noexcept(noexcept(any_secret::any_access::cast<T>(&operand))) {
+    return any_secret::any_access::cast<T>(&operand);
 }
 
-template<class T>
-T *any_cast(any *operand) noexcept {
-    if (operand == nullptr || operand->type() != typeid(T))
-        return nullptr;
-    
-    return operand->cast<T>();
+// the result would refer into a temporary
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+void try_any_cast(any_secret::any_storage<Size, Align, Vtable, Alloc> &&operand) = delete;
+
+// skips the type test, the behavior is undefined unless operand holds a T
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+const T &unchecked_any_cast(const any_secret::any_storage<Size, Align, Vtable, Alloc> &operand) noexcept {
+    return *any_secret::any_access::unchecked_cast<T>(&operand);
+}
+
+template<class T, std::size_t Size, std::size_t Align, class Vtable, class Alloc>
+T &unchecked_any_cast(any_secret::any_storage<Size, Align, Vtable, Alloc> &operand) noexcept(noexcept(any_secret::any_access::unchecked_cast<T>(&operand))) {
+    return *any_secret::any_access::unchecked_cast<T>(&operand);
+}
+
+template<std::size_t Size, std::size_t Align, class Alloc>
+void swap(basic_any<Size, Align, Alloc> &lhs, basic_any<Size, Align, Alloc> &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+template<std::size_t Size, std::size_t Align, class Alloc>
+void swap(basic_unique_any<Size, Align, Alloc> &lhs, basic_unique_any<Size, Align, Alloc> &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
 }
 
 namespace std {
     template<>
-    void swap(any &lhs, any &rhs) {
+    inline void swap(any &lhs, any &rhs) noexcept {
         lhs.swap(rhs);
     }
 }
 
-#endif
\ No newline at end of file
+#endif
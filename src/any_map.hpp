@@ -0,0 +1,200 @@
+#ifndef ANY_MAP_HPP
+#define ANY_MAP_HPP
+
+#include "any.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// any_map holds at most one value per type, like a std::unordered_map<std::type_index, any>. The key of a type
+// is the vtable it gets in an any. Slots are placed by a hash of the type signature, computed at compile time
+// and equal in every shared object, into a flat table probed linearly. Each slot holds its value in an any, so
+// small values live in the table itself. The table is kept at most half full, which resolves most lookups in
+// one probe, and erasing shifts the following slots back instead of leaving tombstones. A type whose vtable
+// was instantiated in another shared object lands on the same probe sequence and is found by comparing types
+// when the hashes are equal, define ANY_UNIQUE_VTABLES to skip that
+
+class any_map {
+private:
+    using key_type = const any_secret::vtable_storage *;
+
+    struct slot {
+        key_type key = nullptr;
+        std::uint64_t hash = 0;
+        any value;
+    };
+
+    std::vector<slot> slots;
+    std::size_t count = 0;
+    unsigned bits = 0;
+
+    template<class T>
+    static key_type key_of() noexcept {
+        return any_secret::any_access::vtable_for<std::decay_t<T>, any>();
+    }
+
+    template<class T>
+    using hash_of = any_secret::type_hash<std::decay_t<T>>;
+
+    std::size_t mask() const noexcept {
+        return slots.size() - 1;
+    }
+
+    std::size_t home(std::uint64_t hash) const noexcept {
+        constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>((hash * multiplier) >> (64 - bits));
+    }
+
+    // the slot holding T, slots.size() when there is none
+    template<class T>
+    std::size_t find() const noexcept {
+        if (count == 0)
+            return slots.size();
+
+        key_type key = key_of<T>();
+        constexpr std::uint64_t hash = hash_of<T>::value;
+        for (std::size_t i = home(hash); slots[i].key != nullptr; i = (i + 1) & mask()) {
+            if (slots[i].key == key)
+                return i;
+#ifndef ANY_UNIQUE_VTABLES
+            if (slots[i].hash == hash && *slots[i].key->type == any_type_id<T>())
+                return i;
+#endif
+        }
+        return slots.size();
+    }
+
+    // the empty slot where hash goes, the table shall have room
+    std::size_t vacancy(std::uint64_t hash) const noexcept {
+        std::size_t i = home(hash);
+        while (slots[i].key != nullptr)
+            i = (i + 1) & mask();
+        return i;
+    }
+
+    void rehash(unsigned new_bits) {
+        std::vector<slot> old(std::size_t{1} << new_bits);
+        old.swap(slots);
+        bits = new_bits;
+
+        for (slot &s : old) {
+            if (s.key != nullptr) {
+                slot &target = slots[vacancy(s.hash)];
+                target.key = s.key;
+                target.hash = s.hash;
+                target.value = std::move(s.value);
+            }
+        }
+    }
+
+public:
+    using size_type = std::size_t;
+
+    size_type size() const noexcept {
+        return count;
+    }
+
+    bool empty() const noexcept {
+        return count == 0;
+    }
+
+    // constructs the value of type T from args, replacing the one held before. The map is left unchanged
+    // when the construction throws
+    template<class T, class... Args>
+    std::decay_t<T> &emplace(Args &&...args) {
+        using U = std::decay_t<T>;
+
+        std::size_t i = find<T>();
+        if (i != slots.size()) {
+            any value(std::in_place_type<U>, std::forward<Args>(args)...);
+            slots[i].value = std::move(value);
+            return *any_secret::any_access::unchecked_cast<U>(&slots[i].value);
+        }
+
+        if (2 * (count + 1) > slots.size())
+            rehash(bits == 0 ? 3 : bits + 1);
+
+        slot &target = slots[vacancy(hash_of<T>::value)];
+        U &value = target.value.template emplace<U>(std::forward<Args>(args)...);
+        target.key = key_of<T>();
+        target.hash = hash_of<T>::value;
+        ++count;
+        return value;
+    }
+
+    template<class T>
+    std::decay_t<T> &insert_or_assign(T &&value) {
+        return emplace<std::decay_t<T>>(std::forward<T>(value));
+    }
+
+    // the value of type T, nullptr when there is none
+    template<class T>
+    T *get_if() noexcept {
+        std::size_t i = find<T>();
+        return i == slots.size() ? nullptr : any_secret::any_access::unchecked_cast<T>(&slots[i].value);
+    }
+
+    template<class T>
+    const T *get_if() const noexcept {
+        return const_cast<any_map *>(this)->get_if<T>();
+    }
+
+    // throws bad_any_cast when there is no value of type T
+    template<class T>
+    T &get() {
+        T *value = get_if<T>();
+        if (value == nullptr)
+            throw bad_any_cast();
+        return *value;
+    }
+
+    template<class T>
+    const T &get() const {
+        return const_cast<any_map *>(this)->get<T>();
+    }
+
+    template<class T>
+    bool contains() const noexcept {
+        return find<T>() != slots.size();
+    }
+
+    // returns whether there was a value of type T
+    template<class T>
+    bool erase() noexcept {
+        std::size_t i = find<T>();
+        if (i == slots.size())
+            return false;
+
+        slots[i].value.reset();
+        slots[i].key = nullptr;
+        --count;
+
+        // moves back the following slots that the hole would make unreachable
+        for (std::size_t j = (i + 1) & mask(); slots[j].key != nullptr; j = (j + 1) & mask()) {
+            std::size_t h = home(slots[j].hash);
+            bool reachable = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+            if (reachable)
+                continue;
+
+            slots[i].key = std::exchange(slots[j].key, nullptr);
+            slots[i].hash = slots[j].hash;
+            slots[i].value = std::move(slots[j].value);
+            i = j;
+        }
+        return true;
+    }
+
+    // destroys every value, the table keeps its size
+    void clear() noexcept {
+        for (slot &s : slots) {
+            s.key = nullptr;
+            s.value.reset();
+        }
+        count = 0;
+    }
+};
+
+#endif
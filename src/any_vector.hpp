@@ -0,0 +1,304 @@
+#ifndef ANY_VECTOR_HPP
+#define ANY_VECTOR_HPP
+
+#include "any.hpp"
+#include "relocating_vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// any_vector holds values of any copyable type like a std::vector<any>, but keeps the values of each type
+// contiguous in a relocating_vector of their own, a segment. Segments are keyed by the vtable the type gets
+// in an any. An index of (segment, slot) pairs keeps the order of insertion, so values can still be reached
+// by position. for_each<T> walks one segment without type tests and clear() runs one destructor loop per
+// segment. Values are appended and removed at the back only, so positions stay valid. Positions are 32 bits,
+// an any_vector holds at most max_size() values
+
+class any_vector {
+private:
+    using key_type = const any_secret::vtable_storage *;
+
+    // the operations on a type-erased relocating_vector<T>
+    struct segment_ops {
+        key_type key;
+        std::uint64_t hash;
+        const any_type_info *type;
+        void *(*clone)(const void *values);
+        void (*destroy)(void *values) noexcept;
+        void (*clear)(void *values) noexcept;
+        void (*pop_back)(void *values) noexcept;
+    };
+
+    template<class T>
+    struct segment_of {
+        using values_type = relocating_vector<T>;
+
+        static values_type &values(void *values) noexcept {
+            return *static_cast<values_type *>(values);
+        }
+
+        static void *clone(const void *values) {
+            return new values_type(*static_cast<const values_type *>(values));
+        }
+
+        static void destroy(void *values) noexcept {
+            delete static_cast<values_type *>(values);
+        }
+
+        static void clear(void *values) noexcept {
+            segment_of::values(values).clear();
+        }
+
+        static void pop_back(void *values) noexcept {
+            segment_of::values(values).pop_back();
+        }
+
+        static constexpr segment_ops ops = {any_secret::any_access::vtable_for<T, any>(), any_secret::type_hash<T>::value, &any_type_id<T>(),
+                                            clone, destroy, clear, pop_back};
+    };
+
+    struct segment {
+        const segment_ops *ops;
+        void *values;
+
+        segment(const segment_ops *ops, void *values) noexcept
+            : ops{ops}, values{values}
+        {}
+
+        segment(segment &&other) noexcept
+            : ops{other.ops}, values{std::exchange(other.values, nullptr)}
+        {}
+
+        segment &operator=(segment &&) = delete;
+
+        ~segment() {
+            if (values != nullptr)
+                ops->destroy(values);
+        }
+    };
+
+    struct entry {
+        std::uint32_t segment;
+        std::uint32_t slot;
+    };
+
+    std::vector<segment> segments;
+    std::vector<entry> entries;
+
+    // vtables are unique per type in the common case, the type comparison covers the others when the
+    // compile-time hashes of the types are equal
+    template<class T>
+    static bool matches(const segment_ops *ops) noexcept {
+#ifndef ANY_UNIQUE_VTABLES
+        return ops->key == any_secret::any_access::vtable_for<T, any>() ||
+               (ops->hash == any_secret::type_hash<T>::value && *ops->type == any_type_id<T>());
+#else
+        return ops->key == any_secret::any_access::vtable_for<T, any>();
+#endif
+    }
+
+    // the position of the segment of T, segments.size() when there is none. The vtable addresses are
+    // scanned first, the type comparison only runs when none of them matches
+    template<class T>
+    std::size_t find() const noexcept {
+        key_type key = any_secret::any_access::vtable_for<T, any>();
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            if (segments[i].ops->key == key)
+                return i;
+        }
+
+#ifndef ANY_UNIQUE_VTABLES
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            if (segments[i].ops->hash == any_secret::type_hash<T>::value && *segments[i].ops->type == any_type_id<T>())
+                return i;
+        }
+#endif
+        return segments.size();
+    }
+
+    template<class T>
+    std::size_t find_or_add() {
+        std::size_t i = find<T>();
+        if (i == segments.size()) {
+            void *values = new relocating_vector<T>();
+            try {
+                segments.emplace_back(&segment_of<T>::ops, values);
+            }
+            catch (...) {
+                segment_of<T>::destroy(values);
+                throw;
+            }
+        }
+        return i;
+    }
+
+    template<class T>
+    relocating_vector<T> &values_at(std::size_t i) const noexcept {
+        return segment_of<T>::values(segments[i].values);
+    }
+
+public:
+    using size_type = std::size_t;
+
+    any_vector() noexcept = default;
+
+    any_vector(const any_vector &other)
+        : entries(other.entries)
+    {
+        segments.reserve(other.segments.size());
+        for (const segment &s : other.segments) {
+            void *values = s.ops->clone(s.values);
+            segments.emplace_back(s.ops, values);
+        }
+    }
+
+    any_vector(any_vector &&other) noexcept = default;
+
+    any_vector &operator=(any_vector rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    void swap(any_vector &other) noexcept {
+        segments.swap(other.segments);
+        entries.swap(other.entries);
+    }
+
+    template<class ValueType, class... Args>
+    std::decay_t<ValueType> &emplace_back(Args &&...args) {
+        using T = std::decay_t<ValueType>;
+        static_assert(std::is_copy_constructible<T>::value, "ValueType shall satisfy the CopyConstructible requirements.");
+
+        // also bounds the slots, a segment never holds more values than the index. Segments are one per type
+        if (entries.size() == max_size())
+            throw std::length_error("any_vector holds max_size() values");
+
+        std::size_t i = find_or_add<T>();
+        relocating_vector<T> &values = values_at<T>(i);
+
+        // the index grows before the value is added, so a failed push leaves both unchanged
+        if (entries.size() == entries.capacity())
+            entries.reserve(2 * entries.size() + 1);
+
+        T &value = values.emplace_back(std::forward<Args>(args)...);
+        entries.push_back({static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(values.size() - 1)});
+        return value;
+    }
+
+    template<class ValueType>
+    void push_back(ValueType &&value) {
+        emplace_back<std::decay_t<ValueType>>(std::forward<ValueType>(value));
+    }
+
+    void pop_back() noexcept {
+        const segment &s = segments[entries.back().segment];
+        s.ops->pop_back(s.values);
+        entries.pop_back();
+    }
+
+    // destroys every value, the segments keep their storage
+    void clear() noexcept {
+        for (segment &s : segments)
+            s.ops->clear(s.values);
+        entries.clear();
+    }
+
+    size_type size() const noexcept {
+        return entries.size();
+    }
+
+    bool empty() const noexcept {
+        return entries.empty();
+    }
+
+    // positions are stored in 32 bits
+    static constexpr size_type max_size() noexcept {
+        return std::numeric_limits<std::uint32_t>::max();
+    }
+
+    void reserve(size_type n) {
+        entries.reserve(n);
+    }
+
+    template<class T>
+    void reserve(size_type n) {
+        values_at<T>(find_or_add<T>()).reserve(n);
+    }
+
+    const any_type_info &type(size_type i) const noexcept {
+        return *segments[entries[i].segment].ops->type;
+    }
+
+    // the value at position i when it is a T, nullptr otherwise
+    template<class T>
+    T *get_if(size_type i) noexcept {
+        const segment &s = segments[entries[i].segment];
+        if (!matches<T>(s.ops))
+            return nullptr;
+        return &segment_of<T>::values(s.values)[entries[i].slot];
+    }
+
+    template<class T>
+    const T *get_if(size_type i) const noexcept {
+        return const_cast<any_vector *>(this)->get_if<T>(i);
+    }
+
+    // throws bad_any_cast when the value at position i is not a T
+    template<class T>
+    T &get(size_type i) {
+        T *value = get_if<T>(i);
+        if (value == nullptr)
+            throw bad_any_cast();
+        return *value;
+    }
+
+    template<class T>
+    const T &get(size_type i) const {
+        return const_cast<any_vector *>(this)->get<T>(i);
+    }
+
+    // the number of values of type T
+    template<class T>
+    size_type count() const noexcept {
+        std::size_t i = find<T>();
+        return i == segments.size() ? 0 : values_at<T>(i).size();
+    }
+
+    // the values of type T in insertion order, contiguous, count<T>() of them
+    template<class T>
+    T *data() noexcept {
+        std::size_t i = find<T>();
+        return i == segments.size() ? nullptr : values_at<T>(i).data();
+    }
+
+    template<class T>
+    const T *data() const noexcept {
+        return const_cast<any_vector *>(this)->data<T>();
+    }
+
+    // calls f with every value of type T in insertion order
+    template<class T, class F>
+    void for_each(F &&f) {
+        T *values = data<T>();
+        for (std::size_t i = 0, n = count<T>(); i < n; ++i)
+            f(values[i]);
+    }
+
+    template<class T, class F>
+    void for_each(F &&f) const {
+        const T *values = data<T>();
+        for (std::size_t i = 0, n = count<T>(); i < n; ++i)
+            f(values[i]);
+    }
+};
+
+inline void swap(any_vector &lhs, any_vector &rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+#endif
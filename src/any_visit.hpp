@@ -0,0 +1,300 @@
+#ifndef ANY_VISIT_HPP
+#define ANY_VISIT_HPP
+
+#include "any.hpp"
+#include "type_lists.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// visit<TL::type_list<Ts...>>(operand, visitor) calls visitor with the value held by operand when its type is
+// one of Ts. The handlers are a table of function pointers generated from the list. The vtable addresses of Ts
+// are a constant array, short lists find the stored type by comparing its vtable address with each of them.
+// Longer lists look up the compile-time hash of the type, which every vtable carries, in an index that is
+// itself built at compile time, so a type outside the list is also rejected in one probe.
+// visit2 dispatches on the types held by two anys through a table with one handler per pair of types
+
+namespace any_secret {
+    template<class Storage, class List>
+    struct visit_table;
+
+    template<class Storage, class... Ts>
+    struct visit_table<Storage, TL::type_list<Ts...>> {
+        static_assert(sizeof...(Ts) > 0, "the type_list shall not be empty");
+
+        static constexpr std::size_t size = sizeof...(Ts);
+
+        static constexpr std::size_t bucket_bits() noexcept {
+            std::size_t bits = 1;
+            while ((std::size_t{1} << bits) < 2 * size)
+                ++bits;
+            return bits;
+        }
+
+        static constexpr std::size_t buckets = std::size_t{1} << bucket_bits();
+
+        static constexpr const vtable_storage *vtables[size] = {any_access::vtable_for<Ts, Storage>()...};
+        static constexpr std::uint64_t hashes[size] = {type_hash<Ts>::value...};
+#ifndef ANY_UNIQUE_VTABLES
+        static constexpr const any_type_info *types[size] = {&any_type_id<Ts>()...};
+#endif
+
+        // up to this many types a scan of vtables is as fast as a probe of the index
+        static constexpr std::size_t scan_limit = 8;
+
+        // whether Ts[i] is the type held by vtable, a vtable made in another shared object is told by the type
+        static bool matches(std::size_t i, const vtable_storage *vtable) noexcept {
+#ifndef ANY_UNIQUE_VTABLES
+            return vtables[i] == vtable || *vtable->type == *types[i];
+#else
+            return vtables[i] == vtable;
+#endif
+        }
+
+        // open addressing on the type hashes, which are constants, so the index is built at compile time.
+        // Slots holding size are free
+        struct index {
+            std::uint64_t keys[buckets];
+            std::size_t slots[buckets];
+
+            static constexpr std::size_t home(std::uint64_t hash) noexcept {
+                return static_cast<std::size_t>((hash * 0x9E3779B97F4A7C15ull) >> (64 - bucket_bits()));
+            }
+
+            constexpr index() noexcept
+                : keys{}, slots{}
+            {
+                for (std::size_t i = 0; i < buckets; ++i)
+                    slots[i] = size;
+
+                for (std::size_t i = 0; i < size; ++i) {
+                    // a type listed twice keeps its first handler
+                    bool listed = false;
+                    for (std::size_t j = 0; j < i; ++j)
+                        listed = listed || vtables[j] == vtables[i];
+                    if (listed)
+                        continue;
+
+                    std::size_t bucket = home(hashes[i]);
+                    while (slots[bucket] != size)
+                        bucket = (bucket + 1) & (buckets - 1);
+                    keys[bucket] = hashes[i];
+                    slots[bucket] = i;
+                }
+            }
+
+            std::size_t find(const vtable_storage *vtable) const noexcept {
+                for (std::size_t bucket = home(vtable->hash); slots[bucket] != size; bucket = (bucket + 1) & (buckets - 1)) {
+                    if (keys[bucket] == vtable->hash && matches(slots[bucket], vtable))
+                        return slots[bucket];
+                }
+
+                return size;
+            }
+        };
+
+        static constexpr index table{};
+
+        // the position in Ts of the type held by vtable, size when it is not in the list
+        static std::size_t find(const vtable_storage *vtable) noexcept {
+            if constexpr (size <= scan_limit) {
+                // the first match wins, so a type listed twice keeps its first handler as with the index
+                for (std::size_t i = 0; i < size; ++i) {
+                    if (vtables[i] == vtable)
+                        return i;
+                }
+
+#ifndef ANY_UNIQUE_VTABLES
+                // a value created in another shared object has its own copy of the vtable, the type hashes rule
+                // out the other types before identities are compared
+                for (std::size_t i = 0; i < size; ++i) {
+                    if (hashes[i] == vtable->hash && *vtable->type == *types[i])
+                        return i;
+                }
+#endif
+                return size;
+            }
+            else
+                return table.find(vtable);
+        }
+
+        template<class Operand, class Visitor>
+        using result_t = decltype(std::declval<Visitor>()(*any_access::unchecked_cast<typename TL::get<0, TL::type_list<Ts...>>::type>(std::declval<Operand *>())));
+
+        template<class T, class Operand, class Visitor>
+        static result_t<Operand, Visitor> handle(Operand &operand, Visitor &visitor) {
+            return std::forward<Visitor>(visitor)(*any_access::unchecked_cast<T>(&operand));
+        }
+
+        template<class Operand, class Visitor>
+        using handler_t = result_t<Operand, Visitor> (*)(Operand &, Visitor &);
+
+        template<class Operand, class Visitor>
+        static constexpr handler_t<Operand, Visitor> handlers[size] = {&handle<Ts, Operand, Visitor>...};
+    };
+
+    struct throw_bad_any_cast {};
+
+    template<class List, class Operand, class Visitor, class Fallback>
+    decltype(auto) visit(Operand &operand, Visitor &&visitor, Fallback &&fallback) {
+        using table = visit_table<std::remove_const_t<Operand>, List>;
+        using result_type = typename table::template result_t<Operand, Visitor>;
+
+        const vtable_storage *vtable = any_access::vtable(operand);
+        if (vtable != nullptr) {
+            std::size_t slot = table::find(vtable);
+            if (slot != table::size)
+                return table::template handlers<Operand, Visitor>[slot](operand, visitor);
+        }
+
+        if constexpr (std::is_same<std::decay_t<Fallback>, throw_bad_any_cast>::value)
+            throw bad_any_cast();
+        else
+            return static_cast<result_type>(std::forward<Fallback>(fallback)(operand));
+    }
+
+    // handlers for every pair of types from ListA and ListB, laid out row by row
+    template<class ListA, class ListB, bool Symmetric>
+    struct visit2_table;
+
+    template<class... As, class... Bs, bool Symmetric>
+    struct visit2_table<TL::type_list<As...>, TL::type_list<Bs...>, Symmetric> {
+        static constexpr std::size_t rows = sizeof...(As);
+        static constexpr std::size_t columns = sizeof...(Bs);
+
+        template<class T, class Operand>
+        using value_t = std::conditional_t<std::is_const<Operand>::value, const T, T>;
+
+        // the visitor takes the pair in order, or reversed when the dispatch is symmetric
+        template<class A, class B, class OperandA, class OperandB, class Visitor>
+        static constexpr bool forward_v = std::is_invocable<Visitor, value_t<A, OperandA> &, value_t<B, OperandB> &>::value;
+
+        template<class A, class B, class OperandA, class OperandB, class Visitor>
+        static constexpr bool reverse_v = Symmetric && !forward_v<A, B, OperandA, OperandB, Visitor> &&
+                                          std::is_invocable<Visitor, value_t<B, OperandB> &, value_t<A, OperandA> &>::value;
+
+        template<class OperandA, class OperandB, class Visitor, class Fallback>
+        static auto result() {
+            using A = typename TL::get<0, TL::type_list<As...>>::type;
+            using B = typename TL::get<0, TL::type_list<Bs...>>::type;
+
+            if constexpr (!std::is_same<std::decay_t<Fallback>, throw_bad_any_cast>::value)
+                return type_tag<decltype(std::declval<Fallback>()(std::declval<OperandA &>(), std::declval<OperandB &>()))>{};
+            else if constexpr (reverse_v<A, B, OperandA, OperandB, Visitor>)
+                return type_tag<std::invoke_result_t<Visitor, value_t<B, OperandB> &, value_t<A, OperandA> &>>{};
+            else
+                return type_tag<std::invoke_result_t<Visitor, value_t<A, OperandA> &, value_t<B, OperandB> &>>{};
+        }
+
+        template<class T>
+        struct type_tag {
+            using type = T;
+        };
+
+        template<class OperandA, class OperandB, class Visitor, class Fallback>
+        using result_t = typename decltype(result<OperandA, OperandB, Visitor, Fallback>())::type;
+
+        template<class OperandA, class OperandB, class Visitor, class Fallback>
+        static result_t<OperandA, OperandB, Visitor, Fallback> unhandled(OperandA &a, OperandB &b, Fallback &fallback) {
+            if constexpr (std::is_same<std::decay_t<Fallback>, throw_bad_any_cast>::value)
+                throw bad_any_cast();
+            else
+                return static_cast<result_t<OperandA, OperandB, Visitor, Fallback>>(std::forward<Fallback>(fallback)(a, b));
+        }
+
+        template<std::size_t I, class OperandA, class OperandB, class Visitor, class Fallback>
+        static result_t<OperandA, OperandB, Visitor, Fallback> handle(OperandA &a, OperandB &b, Visitor &visitor, Fallback &fallback) {
+            using A = typename TL::get<I / columns, TL::type_list<As...>>::type;
+            using B = typename TL::get<I % columns, TL::type_list<Bs...>>::type;
+            using result_type = result_t<OperandA, OperandB, Visitor, Fallback>;
+
+            if constexpr (forward_v<A, B, OperandA, OperandB, Visitor>)
+                return static_cast<result_type>(std::forward<Visitor>(visitor)(*any_access::unchecked_cast<A>(&a), *any_access::unchecked_cast<B>(&b)));
+            else if constexpr (reverse_v<A, B, OperandA, OperandB, Visitor>)
+                return static_cast<result_type>(std::forward<Visitor>(visitor)(*any_access::unchecked_cast<B>(&b), *any_access::unchecked_cast<A>(&a)));
+            else
+                return unhandled<OperandA, OperandB, Visitor>(a, b, fallback);
+        }
+
+        template<class OperandA, class OperandB, class Visitor, class Fallback>
+        using handler_t = result_t<OperandA, OperandB, Visitor, Fallback> (*)(OperandA &, OperandB &, Visitor &, Fallback &);
+
+        template<class OperandA, class OperandB, class Visitor, class Fallback, std::size_t... Is>
+        static constexpr std::array<handler_t<OperandA, OperandB, Visitor, Fallback>, rows * columns> make_handlers(std::index_sequence<Is...>) {
+            return {{&handle<Is, OperandA, OperandB, Visitor, Fallback>...}};
+        }
+
+        template<class OperandA, class OperandB, class Visitor, class Fallback>
+        static constexpr std::array<handler_t<OperandA, OperandB, Visitor, Fallback>, rows * columns> handlers =
+            make_handlers<OperandA, OperandB, Visitor, Fallback>(std::make_index_sequence<rows * columns>{});
+    };
+
+    template<class ListA, class ListB, bool Symmetric, class OperandA, class OperandB, class Visitor, class Fallback>
+    decltype(auto) visit_pair(OperandA &a, OperandB &b, Visitor &&visitor, Fallback &&fallback) {
+        using table = visit2_table<ListA, ListB, Symmetric>;
+
+        const vtable_storage *vtable_a = any_access::vtable(a);
+        const vtable_storage *vtable_b = any_access::vtable(b);
+        if (vtable_a != nullptr && vtable_b != nullptr) {
+            std::size_t row = visit_table<std::remove_const_t<OperandA>, ListA>::find(vtable_a);
+            std::size_t column = visit_table<std::remove_const_t<OperandB>, ListB>::find(vtable_b);
+            if (row != table::rows && column != table::columns)
+                return table::template handlers<OperandA, OperandB, Visitor, Fallback>[row * table::columns + column](a, b, visitor, fallback);
+        }
+
+        return table::template unhandled<OperandA, OperandB, Visitor>(a, b, fallback);
+    }
+}
+
+// visitor is called with a reference to the value, fallback with operand when it is empty or holds a type
+// that is not in List. Both shall return the same type
+template<class List, std::size_t Size, std::size_t Align, class Alloc, class Visitor, class Fallback>
+decltype(auto) visit(basic_any<Size, Align, Alloc> &operand, Visitor &&visitor, Fallback &&fallback) {
+    return any_secret::visit<List>(operand, std::forward<Visitor>(visitor), std::forward<Fallback>(fallback));
+}
+
+template<class List, std::size_t Size, std::size_t Align, class Alloc, class Visitor, class Fallback>
+decltype(auto) visit(const basic_any<Size, Align, Alloc> &operand, Visitor &&visitor, Fallback &&fallback) {
+    return any_secret::visit<List>(operand, std::forward<Visitor>(visitor), std::forward<Fallback>(fallback));
+}
+
+template<class List, std::size_t Size, std::size_t Align, class Alloc, class Visitor, class Fallback>
+decltype(auto) visit(basic_unique_any<Size, Align, Alloc> &operand, Visitor &&visitor, Fallback &&fallback) {
+    return any_secret::visit<List>(operand, std::forward<Visitor>(visitor), std::forward<Fallback>(fallback));
+}
+
+template<class List, std::size_t Size, std::size_t Align, class Alloc, class Visitor, class Fallback>
+decltype(auto) visit(const basic_unique_any<Size, Align, Alloc> &operand, Visitor &&visitor, Fallback &&fallback) {
+    return any_secret::visit<List>(operand, std::forward<Visitor>(visitor), std::forward<Fallback>(fallback));
+}
+
+// throws bad_any_cast when operand is empty or holds a type that is not in List
+template<class List, class Operand, class Visitor,
+         typename std::enable_if_t<any_secret::is_any_storage<std::remove_const_t<Operand>>::value, int> = 0>
+decltype(auto) visit(Operand &operand, Visitor &&visitor) {
+    return any_secret::visit<List>(operand, std::forward<Visitor>(visitor), any_secret::throw_bad_any_cast{});
+}
+
+// calls visitor with the values held by a and b when their types are in ListA and ListB. With Symmetric, a pair
+// the visitor only takes in the other order is passed reversed, so one overload serves both (A, B) and (B, A).
+// fallback is called with a and b when either is empty, holds a type outside its list or the visitor takes
+// neither order of the pair
+template<class ListA, class ListB, bool Symmetric = false, class OperandA, class OperandB, class Visitor, class Fallback,
+         typename std::enable_if_t<any_secret::is_any_storage<std::remove_const_t<OperandA>>::value &&
+                                   any_secret::is_any_storage<std::remove_const_t<OperandB>>::value, int> = 0>
+decltype(auto) visit2(OperandA &a, OperandB &b, Visitor &&visitor, Fallback &&fallback) {
+    return any_secret::visit_pair<ListA, ListB, Symmetric>(a, b, std::forward<Visitor>(visitor), std::forward<Fallback>(fallback));
+}
+
+// throws bad_any_cast instead of calling a fallback, the result type is the one of the first pair of the lists
+template<class ListA, class ListB, bool Symmetric = false, class OperandA, class OperandB, class Visitor,
+         typename std::enable_if_t<any_secret::is_any_storage<std::remove_const_t<OperandA>>::value &&
+                                   any_secret::is_any_storage<std::remove_const_t<OperandB>>::value, int> = 0>
+decltype(auto) visit2(OperandA &a, OperandB &b, Visitor &&visitor) {
+    return any_secret::visit_pair<ListA, ListB, Symmetric>(a, b, std::forward<Visitor>(visitor), any_secret::throw_bad_any_cast{});
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef ARENA_ANY_HPP
+#define ARENA_ANY_HPP
+
+#include "any.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// arena_any is a basic_any whose heap values are placed in an any_arena, a monotonic buffer for data that
+// lives as long as a request. The anys of a request are meant to be placed in the arena too, with
+// arena.make<arena_any>(args...), and dropped all at once when the arena is reset:
+//
+//     any_arena arena;
+//     arena_any &value = arena.make<arena_any>(particle{...});
+//     ...
+//     arena.reset(); // runs the pending destructors and releases the memory
+//
+// Heap values are never freed one by one. Destroying an arena_any holding a trivially destructible value does
+// not even reach the vtable, the others are linked into a list of destructors when made. Destroying such an
+// arena_any runs the destructor through the vtable and takes it off the list, which costs as much as destroying
+// a pooled heap value. Resetting or destroying the arena runs the destructors still on the list in one loop.
+//
+// The arena is not thread safe. An arena_any shall not be used or destroyed after its arena is reset, which
+// debug builds assert when the value has a destructor
+
+class any_arena {
+public:
+    // a destructor to run when the arena is reset, nullptr once the value was destroyed
+    struct cleanup {
+        void (*destroy)(cleanup *entry) noexcept;
+        cleanup *next;
+    };
+
+private:
+    std::pmr::monotonic_buffer_resource resource;
+    cleanup *cleanups = nullptr;
+    std::size_t resets = 0;
+
+    void run_cleanups() noexcept {
+        for (cleanup *entry = std::exchange(cleanups, nullptr); entry != nullptr; entry = entry->next) {
+            if (entry->destroy != nullptr)
+                entry->destroy(entry);
+        }
+    }
+
+public:
+    any_arena() = default;
+
+    explicit any_arena(std::size_t initial_size)
+        : resource(initial_size)
+    {}
+
+    // starts with the given buffer, the arena takes more memory from the heap once it is full
+    any_arena(void *buffer, std::size_t size)
+        : resource(buffer, size)
+    {}
+
+    any_arena(const any_arena &) = delete;
+    any_arena &operator=(const any_arena &) = delete;
+
+    ~any_arena() {
+        run_cleanups();
+    }
+
+    void *allocate(std::size_t size, std::size_t alignment) {
+        return resource.allocate(size, alignment);
+    }
+
+    // constructs an Any using this arena in the arena itself. It is never destroyed on its own, the destructor
+    // of its value runs when the arena is reset
+    template<class Any, class... Args>
+    Any &make(Args &&...args) {
+        return *new (allocate(sizeof(Any), alignof(Any))) Any(std::allocator_arg, *this, std::forward<Args>(args)...);
+    }
+
+    // entry lives in the arena, its destructor runs on reset unless disarmed before
+    void push_cleanup(cleanup *entry) noexcept {
+        entry->next = cleanups;
+        cleanups = entry;
+    }
+
+    // runs the pending destructors and releases the memory, keeping the initial buffer
+    void reset() noexcept {
+        run_cleanups();
+        resource.release();
+        ++resets;
+    }
+
+    // the number of resets so far, what was allocated before the last one is gone
+    std::size_t generation() const noexcept {
+        return resets;
+    }
+
+    std::pmr::memory_resource *memory_resource() noexcept {
+        return &resource;
+    }
+};
+
+// allocator for an any_arena, deallocating does nothing since the arena releases its memory at once
+template<class T>
+class arena_allocator {
+private:
+    any_arena *owner;
+#ifndef NDEBUG
+    std::size_t generation;
+#endif
+
+    template<class U>
+    friend class arena_allocator;
+
+public:
+    using value_type = T;
+
+    arena_allocator(any_arena &arena) noexcept
+        : owner{&arena}
+#ifndef NDEBUG
+        , generation{arena.generation()}
+#endif
+    {}
+
+    template<class U>
+    arena_allocator(const arena_allocator<U> &other) noexcept
+        : owner{other.owner}
+#ifndef NDEBUG
+        , generation{other.generation}
+#endif
+    {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(owner->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, std::size_t) noexcept {}
+
+    any_arena &arena() const noexcept {
+        return *owner;
+    }
+
+    // false once the arena was reset after this allocator was made from it
+    bool current() const noexcept {
+#ifndef NDEBUG
+        return generation == owner->generation();
+#else
+        return true;
+#endif
+    }
+
+    template<class U>
+    bool operator==(const arena_allocator<U> &rhs) const noexcept {
+        return owner == rhs.owner;
+    }
+
+    template<class U>
+    bool operator!=(const arena_allocator<U> &rhs) const noexcept {
+        return owner != rhs.owner;
+    }
+};
+
+namespace any_secret {
+    template<class ValueType, class T>
+    struct vtable_heap<ValueType, arena_allocator<T>> {
+        using Alloc = arena_allocator<T>;
+
+        static constexpr bool trivially_destructible = std::is_trivially_destructible<ValueType>::value;
+
+        // a value with a destructor comes after its entry in the cleanup list of the arena
+        struct node {
+            any_arena::cleanup entry;
+            alignas(ValueType) unsigned char value[sizeof(ValueType)];
+        };
+
+        static ValueType *object(const void *storage) noexcept {
+            return *reinterpret_cast<ValueType *const *>(storage);
+        }
+
+        static node *owner(ValueType *value) noexcept {
+            return reinterpret_cast<node *>(reinterpret_cast<unsigned char *>(value) - offsetof(node, value));
+        }
+
+        static const Alloc &allocator(const void *allocator) noexcept {
+            return *static_cast<const Alloc *>(allocator);
+        }
+
+        static void destroy_node(any_arena::cleanup *entry) noexcept {
+            std::launder(reinterpret_cast<ValueType *>(reinterpret_cast<node *>(entry)->value))->~ValueType();
+        }
+
+        // the memory of a constructor that throws stays in the arena until it is reset
+        template<class... Args>
+        static ValueType *create(const Alloc &allocator, Args &&...args) {
+            any_arena &arena = allocator.arena();
+            ValueType *value;
+            if constexpr (trivially_destructible)
+                value = new (arena.allocate(sizeof(ValueType), alignof(ValueType))) ValueType(std::forward<Args>(args)...);
+            else {
+                node *n = static_cast<node *>(arena.allocate(sizeof(node), alignof(node)));
+                value = new (n->value) ValueType(std::forward<Args>(args)...);
+                n->entry.destroy = &destroy_node;
+                arena.push_cleanup(&n->entry);
+            }
+
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::heap_allocations));
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::bytes_allocated, sizeof(ValueType)));
+            return value;
+        }
+
+        static void move(void *src, void *dest) noexcept {
+            *reinterpret_cast<void **>(dest) = object(src);
+            *reinterpret_cast<void **>(src) = nullptr;
+        }
+
+        static void copy(const void *src, void *dest, const void *allocator) {
+            if constexpr (std::is_copy_constructible<ValueType>::value)
+                *reinterpret_cast<void **>(dest) = create(vtable_heap::allocator(allocator), *object(src));
+        }
+
+        static void destroy(void *storage, const void *allocator) noexcept {
+            if constexpr (!trivially_destructible) {
+                assert(vtable_heap::allocator(allocator).current() && "arena_any destroyed after its arena was reset");
+                ValueType *value = object(storage);
+                value->~ValueType();
+                owner(value)->entry.destroy = nullptr;
+            }
+            *reinterpret_cast<void **>(storage) = nullptr;
+        }
+
+        static void unshare(void *) noexcept {}
+
+        static bool exclusive(const void *) noexcept {
+            return true;
+        }
+
+        static const vtable_storage *convert(void *src, void *dest, std::size_t inline_size, std::size_t inline_align,
+                                             const void *src_allocator, const void *dest_allocator)
+        {
+            if constexpr (std::is_nothrow_move_constructible<ValueType>::value) {
+                if (fits_inline<ValueType>(inline_size, inline_align)) {
+                    new (dest) ValueType(std::move(*object(src)));
+                    ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::inline_placements));
+                    destroy(src, src_allocator);
+                    return &vtable_stack<ValueType, Alloc>::vtable;
+                }
+            }
+
+            if (allocator(src_allocator) == allocator(dest_allocator))
+                move(src, dest);
+            else if constexpr (std::is_move_constructible<ValueType>::value) {
+                *reinterpret_cast<void **>(dest) = create(allocator(dest_allocator), std::move(*object(src)));
+                destroy(src, src_allocator);
+            }
+            else
+                throw std::logic_error("an immovable value cannot change arena");
+
+            return &vtable;
+        }
+
+        static constexpr vtable_t<ValueType> vtable = make_vtable<ValueType>(false, true, trivially_destructible, move, copy, destroy, convert);
+    };
+}
+
+template<std::size_t InlineSize, std::size_t InlineAlign>
+using basic_arena_any = basic_any<InlineSize, InlineAlign, arena_allocator<std::byte>>;
+
+template<std::size_t InlineSize, std::size_t InlineAlign>
+using basic_arena_unique_any = basic_unique_any<InlineSize, InlineAlign, arena_allocator<std::byte>>;
+
+using arena_any = basic_arena_any<2*sizeof(void*), alignof(void*)>;
+using arena_unique_any = basic_arena_unique_any<2*sizeof(void*), alignof(void*)>;
+
+#endif
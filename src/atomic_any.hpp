@@ -0,0 +1,142 @@
+#ifndef ATOMIC_ANY_HPP
+#define ATOMIC_ANY_HPP
+
+#include "any.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// basic_atomic_any<Any> holds an Any that is read and replaced concurrently. The value lives in a heap node that
+// is never written once published. A writer swaps in a new node and frees the old one after a grace period,
+// that is once every reader that could have seen the old node has left.
+//
+// Readers are wait-free. A reader adds one to a reader count, loads the node and subtracts one again, with no
+// loop and no lock. The counts are spread over cache line sized stripes picked per thread, and each stripe has
+// one count per epoch. Writers take a mutex among themselves and wait for the readers of the previous epoch.
+// Use basic_atomic_any<shared_any> to make load() a reference count increment for heap values
+
+template<class Any>
+class basic_atomic_any {
+public:
+    using value_type = Any;
+
+    basic_atomic_any()
+        : current(new node{})
+    {}
+
+    explicit basic_atomic_any(Any value)
+        : current(new node{std::move(value)})
+    {}
+
+    basic_atomic_any(const basic_atomic_any &) = delete;
+    basic_atomic_any &operator=(const basic_atomic_any &) = delete;
+
+    ~basic_atomic_any() {
+        delete current.load(std::memory_order_relaxed);
+    }
+
+    // calls f with a const reference to the current value, the reference is valid until f returns
+    template<class F>
+    decltype(auto) read(F &&f) const {
+        std::atomic<std::size_t> &readers = stripes[stripe_index()].readers[epoch.load() & 1];
+        readers.fetch_add(1);
+        reader_exit exit{readers};
+
+        return std::forward<F>(f)(static_cast<const Any &>(current.load()->value));
+    }
+
+    Any load() const {
+        return read([](const Any &value) { return value; });
+    }
+
+    void store(Any value) {
+        exchange(std::move(value));
+    }
+
+    Any exchange(Any value) {
+        std::unique_ptr<node> old = replace(std::make_unique<node>(node{std::move(value)}));
+        return std::move(old->value);
+    }
+
+    // replaces the value with desired when it holds a T equal to expected, otherwise copies the held T into
+    // expected when it holds one
+    template<class T>
+    bool compare_exchange(T &expected, Any desired) {
+        std::unique_ptr<node> next = std::make_unique<node>(node{std::move(desired)});
+        std::unique_ptr<node> old;
+
+        {
+            std::lock_guard<std::mutex> lock(writer);
+            const T *held = any_cast<T>(&std::as_const(current.load()->value));
+            if (held == nullptr || !(*held == expected)) {
+                if (held != nullptr)
+                    expected = *held;
+                return false;
+            }
+
+            old.reset(current.exchange(next.release()));
+            synchronize();
+        }
+
+        return true;
+    }
+
+private:
+    struct node {
+        Any value;
+    };
+
+    static constexpr std::size_t stripe_count = 16;
+
+    struct alignas(64) stripe {
+        std::atomic<std::size_t> readers[2] = {};
+    };
+
+    struct reader_exit {
+        std::atomic<std::size_t> &readers;
+
+        ~reader_exit() {
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    // threads are spread over the stripes in the order they first read
+    static std::size_t stripe_index() noexcept {
+        static std::atomic<std::size_t> next_index{0};
+        thread_local std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % stripe_count;
+        return index;
+    }
+
+    std::unique_ptr<node> replace(std::unique_ptr<node> next) {
+        std::lock_guard<std::mutex> lock(writer);
+        std::unique_ptr<node> old(current.exchange(next.release()));
+        synchronize();
+        return old;
+    }
+
+    // returns once no reader can still hold a node that was replaced before the call. A reader counts itself in
+    // the epoch it loaded, which may be stale by the time it counts, so both epochs are drained in turn.
+    // Readers arriving after a flip count themselves in the other epoch and see the new node
+    void synchronize() noexcept {
+        for (int phase = 0; phase < 2; ++phase) {
+            unsigned drained = epoch.fetch_xor(1) & 1;
+            for (stripe &s : stripes) {
+                while (s.readers[drained].load() != 0)
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    std::atomic<node *> current;
+    std::atomic<unsigned> epoch{0};
+    mutable stripe stripes[stripe_count];
+    std::mutex writer;
+};
+
+using atomic_any = basic_atomic_any<any>;
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef INPLACE_FUNCTION_HPP
+#define INPLACE_FUNCTION_HPP
+
+#include "any.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// inplace_function<R(Args...), Capacity, Align> is a copyable callable wrapper that never allocates. The
+// callable lives in the inline buffer of a basic_any<Capacity, Align>, which gives the copy, move, relocation
+// and destruction, and a callable that does not fit is rejected at compile time. The call goes through one
+// function pointer per stored type, kept next to the any so calling never looks at the vtable.
+//
+// function_ref<R(Args...)> refers to a callable it does not own, for parameters that are only called during
+// the call that receives them
+
+template<class Signature, std::size_t Capacity = 2*sizeof(void*), std::size_t Align = alignof(void*)>
+class inplace_function;
+
+template<class R, class... Args, std::size_t Capacity, std::size_t Align>
+class inplace_function<R(Args...), Capacity, Align> {
+private:
+    using storage_type = basic_any<Capacity, Align>;
+    using invoker_type = R (*)(storage_type &, Args &&...);
+
+    template<class F>
+    static R invoke(storage_type &storage, Args &&...args) {
+        return std::invoke(*any_secret::any_access::unchecked_cast<F>(&storage), std::forward<Args>(args)...);
+    }
+
+    // an empty inplace_function calls this instead of testing for a value on every call
+    static R invoke_empty(storage_type &, Args &&...) {
+        throw std::bad_function_call();
+    }
+
+    template<class F>
+    static constexpr bool is_callable = !std::is_same<std::decay_t<F>, inplace_function>::value &&
+                                        std::is_invocable_r<R, std::decay_t<F> &, Args...>::value;
+
+    template<class F>
+    static bool is_null(const F &f) noexcept {
+        if constexpr (std::is_pointer<F>::value || std::is_member_pointer<F>::value)
+            return f == nullptr;
+        else
+            return false;
+    }
+
+    mutable storage_type callable;
+    invoker_type invoker = &invoke_empty;
+
+public:
+    using result_type = R;
+
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr std::size_t alignment = Align;
+
+    inplace_function() noexcept = default;
+
+    inplace_function(std::nullptr_t) noexcept {}
+
+    template<class F, typename std::enable_if_t<is_callable<F>, int> = 0>
+    inplace_function(F &&f) {
+        using T = std::decay_t<F>;
+        static_assert(storage_type::template is_stored_inline<T>,
+                      "the callable shall fit in Capacity bytes aligned to Align and be nothrow move constructible");
+
+        if (is_null(f))
+            return;
+
+        callable.template emplace<T>(std::forward<F>(f));
+        invoker = &invoke<T>;
+    }
+
+    inplace_function(const inplace_function &other) = default;
+
+    inplace_function(inplace_function &&other) noexcept
+        : callable(std::move(other.callable)), invoker(std::exchange(other.invoker, &invoke_empty))
+    {}
+
+    inplace_function &operator=(const inplace_function &rhs) {
+        inplace_function(rhs).swap(*this);
+        return *this;
+    }
+
+    inplace_function &operator=(inplace_function &&rhs) noexcept {
+        inplace_function(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    inplace_function &operator=(std::nullptr_t) noexcept {
+        callable.reset();
+        invoker = &invoke_empty;
+        return *this;
+    }
+
+    template<class F, typename std::enable_if_t<is_callable<F>, int> = 0>
+    inplace_function &operator=(F &&f) {
+        inplace_function(std::forward<F>(f)).swap(*this);
+        return *this;
+    }
+
+    void swap(inplace_function &other) noexcept {
+        callable.swap(other.callable);
+        std::swap(invoker, other.invoker);
+    }
+
+    explicit operator bool() const noexcept {
+        return callable.has_value();
+    }
+
+    // throws std::bad_function_call when empty
+    R operator()(Args... args) const {
+        return invoker(callable, std::forward<Args>(args)...);
+    }
+};
+
+template<class Signature, std::size_t Capacity, std::size_t Align>
+void swap(inplace_function<Signature, Capacity, Align> &lhs, inplace_function<Signature, Capacity, Align> &rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+template<class Signature, std::size_t Capacity, std::size_t Align>
+bool operator==(const inplace_function<Signature, Capacity, Align> &f, std::nullptr_t) noexcept {
+    return !f;
+}
+
+template<class Signature, std::size_t Capacity, std::size_t Align>
+bool operator!=(const inplace_function<Signature, Capacity, Align> &f, std::nullptr_t) noexcept {
+    return static_cast<bool>(f);
+}
+
+template<class Signature>
+class function_ref;
+
+template<class R, class... Args>
+class function_ref<R(Args...)> {
+private:
+    // functions are kept apart since a function pointer does not convert to void *
+    union target_type {
+        void *object;
+        void (*function)();
+    };
+
+    using invoker_type = R (*)(target_type, Args &&...);
+
+    template<class F>
+    static R invoke_object(target_type target, Args &&...args) {
+        return std::invoke(*static_cast<F *>(target.object), std::forward<Args>(args)...);
+    }
+
+    template<class F>
+    static R invoke_function(target_type target, Args &&...args) {
+        return std::invoke(reinterpret_cast<F *>(target.function), std::forward<Args>(args)...);
+    }
+
+    target_type target;
+    invoker_type invoker;
+
+public:
+    // f shall outlive the function_ref
+    template<class F,
+             typename std::enable_if_t<!std::is_same<std::decay_t<F>, function_ref>::value &&
+                                       std::is_invocable_r<R, F &, Args...>::value, int> = 0>
+    function_ref(F &&f) noexcept {
+        using T = std::remove_reference_t<F>;
+        if constexpr (std::is_function<T>::value) {
+            target.function = reinterpret_cast<void (*)()>(&f);
+            invoker = &invoke_function<T>;
+        }
+        else if constexpr (std::is_pointer<std::decay_t<T>>::value &&
+                           std::is_function<std::remove_pointer_t<std::decay_t<T>>>::value) {
+            // the pointer itself is kept, so a temporary pointer does not dangle
+            target.function = reinterpret_cast<void (*)()>(f);
+            invoker = &invoke_function<std::remove_pointer_t<std::decay_t<T>>>;
+        }
+        else {
+            target.object = const_cast<void *>(static_cast<const volatile void *>(std::addressof(f)));
+            invoker = &invoke_object<T>;
+        }
+    }
+
+    function_ref(const function_ref &other) noexcept = default;
+
+    function_ref &operator=(const function_ref &rhs) noexcept = default;
+
+    R operator()(Args... args) const {
+        return invoker(target, std::forward<Args>(args)...);
+    }
+};
+
+#endif
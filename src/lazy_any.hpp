@@ -0,0 +1,225 @@
+#ifndef LAZY_ANY_HPP
+#define LAZY_ANY_HPP
+
+#include "any.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// basic_lazy_any<Any> holds a factory instead of a value and calls it on the first cast to the value type.
+// The factory is stored in the Any, inline when it fits, and the value replaces it once made, so a value that
+// is never read costs only its factory capture. has_value() and type() answer without calling the factory.
+//
+// Materializing is safe from several threads at once: one thread calls the factory while the others wait for
+// it. When the factory throws the lazy_any stays deferred and the next cast calls it again. Copying a deferred
+// lazy_any copies the factory, which shall then be copy constructible when Any is copyable
+
+namespace any_secret {
+    // key is the vtable the value gets in Any, compared before the type as any_cast does
+    template<class Any>
+    struct lazy_entry {
+        const vtable_storage *key;
+        const any_type_info *type;
+        void (*materialize)(Any &storage);
+    };
+
+    template<class T, class F, class Any>
+    struct lazy_entry_of {
+        static void materialize(Any &storage) {
+            Any value(std::in_place_type<T>, std::invoke(*any_access::unchecked_cast<F>(&storage)));
+            storage = std::move(value);
+        }
+
+        static constexpr lazy_entry<Any> entry = {any_access::vtable_for<T, Any>(), &any_type_id<T>(), materialize};
+    };
+}
+
+template<class Any>
+class basic_lazy_any {
+private:
+    enum phase_type : unsigned char { deferred, busy, ready };
+
+    mutable Any storage;
+    const any_secret::lazy_entry<Any> *entry = nullptr;
+    mutable std::atomic<unsigned char> phase{ready};
+
+    // takes the factory for this thread, waits while another thread holds it
+    bool lock() const noexcept {
+        unsigned char expected = deferred;
+        while (!phase.compare_exchange_weak(expected, busy, std::memory_order_acquire, std::memory_order_acquire)) {
+            if (expected == ready)
+                return false;
+            expected = deferred;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    void unlock(phase_type next) const noexcept {
+        phase.store(next, std::memory_order_release);
+    }
+
+public:
+    using any_type = Any;
+
+    basic_lazy_any() noexcept = default;
+
+    // f is called with no arguments and returns the value, a T or something T is constructible from
+    template<class T, class F>
+    basic_lazy_any(std::in_place_type_t<T>, F &&f) {
+        defer<T>(std::forward<F>(f));
+    }
+
+    basic_lazy_any(const basic_lazy_any &other)
+        : entry(other.entry)
+    {
+        if (other.lock()) {
+            try {
+                storage = other.storage;
+            }
+            catch (...) {
+                other.unlock(deferred);
+                throw;
+            }
+            other.unlock(deferred);
+            phase.store(deferred, std::memory_order_relaxed);
+        }
+        else
+            storage = other.storage;
+    }
+
+    basic_lazy_any(basic_lazy_any &&other) noexcept
+        : storage(std::move(other.storage)), entry(std::exchange(other.entry, nullptr)),
+          phase(other.phase.exchange(ready, std::memory_order_relaxed))
+    {}
+
+    basic_lazy_any &operator=(const basic_lazy_any &rhs) {
+        basic_lazy_any(rhs).swap(*this);
+        return *this;
+    }
+
+    basic_lazy_any &operator=(basic_lazy_any &&rhs) noexcept {
+        basic_lazy_any(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    // replaces the value with a factory of T
+    template<class T, class F>
+    void defer(F &&f) {
+        using factory = std::decay_t<F>;
+        static_assert(std::is_constructible<T, std::invoke_result_t<factory &>>::value,
+                      "T shall be constructible from the result of the factory");
+
+        reset();
+        storage.template emplace<factory>(std::forward<F>(f));
+        entry = &any_secret::lazy_entry_of<T, factory, Any>::entry;
+        phase.store(deferred, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept {
+        storage.reset();
+        entry = nullptr;
+        phase.store(ready, std::memory_order_relaxed);
+    }
+
+    void swap(basic_lazy_any &other) noexcept {
+        storage.swap(other.storage);
+        std::swap(entry, other.entry);
+        phase.store(other.phase.exchange(phase.load(std::memory_order_relaxed), std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    }
+
+    bool has_value() const noexcept {
+        return entry != nullptr;
+    }
+
+    // the type of the value, made or not
+    const any_type_info &type() const noexcept {
+        return entry == nullptr ? any_type_id<void>() : *entry->type;
+    }
+
+    bool is_materialized() const noexcept {
+        return phase.load(std::memory_order_acquire) == ready;
+    }
+
+    // whether the value, made or not, is a T
+    template<class T>
+    bool holds() const noexcept {
+        if constexpr (std::is_copy_constructible<Any>::value && !std::is_copy_constructible<T>::value)
+            return false;
+        else {
+            if (entry == nullptr)
+                return false;
+            if (entry->key == any_secret::any_access::vtable_for<std::remove_cv_t<T>, Any>())
+                return true;
+#ifndef ANY_UNIQUE_VTABLES
+            return *entry->type == any_type_id<T>();
+#else
+            return false;
+#endif
+        }
+    }
+
+    // calls the factory unless the value is made, rethrows what the factory throws. The Any is read-only, storing
+    // another value in it would leave type() naming the old one
+    const Any &value() const {
+        if (phase.load(std::memory_order_acquire) != ready && lock()) {
+            try {
+                entry->materialize(storage);
+            }
+            catch (...) {
+                unlock(deferred);
+                throw;
+            }
+            unlock(ready);
+        }
+        return storage;
+    }
+};
+
+using lazy_any = basic_lazy_any<any>;
+using lazy_unique_any = basic_lazy_any<unique_any>;
+
+// a cast to another type than the value type returns nullptr without calling the factory
+template<class T, class Any>
+const T *any_cast(const basic_lazy_any<Any> *operand) {
+    if (operand == nullptr || !operand->template holds<T>())
+        return nullptr;
+    return any_secret::any_access::unchecked_cast<T>(&operand->value());
+}
+
+// the value of a non-const lazy_any may be written to, the storage is a mutable member
+template<class T, class Any>
+T *any_cast(basic_lazy_any<Any> *operand) {
+    if (operand == nullptr || !operand->template holds<T>())
+        return nullptr;
+    return any_secret::any_access::unchecked_cast<T>(const_cast<Any *>(&operand->value()));
+}
+
+template<class T, class Any>
+T any_cast(const basic_lazy_any<Any> &operand) {
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    auto ptr = any_cast<U>(&operand);
+    if (ptr == nullptr)
+        throw bad_any_cast();
+    return static_cast<T>(*ptr);
+}
+
+template<class T, class Any>
+T any_cast(basic_lazy_any<Any> &operand) {
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    auto ptr = any_cast<U>(&operand);
+    if (ptr == nullptr)
+        throw bad_any_cast();
+    return static_cast<T>(*ptr);
+}
+
+template<class Any>
+void swap(basic_lazy_any<Any> &lhs, basic_lazy_any<Any> &rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef POLY_HPP
+#define POLY_HPP
+
+#include "any.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+// basic_poly<Any, Ops...> is an Any that also knows how to apply each operation in Ops to its value. The
+// operations are compiled into a table per stored type, so hashing, comparing or printing a value is one
+// indirect call, without casting to every candidate type.
+//
+// An operation is a struct with a static member function template apply. Its first parameter is
+// const T & for the value, binary operations take a second const T & that is given a basic_poly holding
+// the same type. The return type shall not be deduced:
+//
+//     struct serialize {
+//         template<class T>
+//         static void apply(const T &value, std::string &out) { out += to_string(value); }
+//     };
+
+namespace any_ops {
+    struct hash {
+        template<class T>
+        static std::size_t apply(const T &value) {
+            return std::hash<T>{}(value);
+        }
+    };
+
+    struct equal {
+        template<class T>
+        static bool apply(const T &lhs, const T &rhs) {
+            return lhs == rhs;
+        }
+    };
+
+    struct less {
+        template<class T>
+        static bool apply(const T &lhs, const T &rhs) {
+            return lhs < rhs;
+        }
+    };
+
+    struct ostream {
+        template<class T>
+        static std::ostream &apply(const T &value, std::ostream &os) {
+            return os << value;
+        }
+    };
+}
+
+namespace any_secret {
+    // stands for the stored type when reading the signature of an operation
+    struct op_probe {};
+
+    template<class Any, class Param>
+    using erased_param_t = std::conditional_t<std::is_same<Param, const op_probe &>::value, const Any &, Param>;
+
+    template<class T, class Any, class Param, class Arg>
+    decltype(auto) unerase(Arg &&arg) noexcept {
+        if constexpr (std::is_same<Param, const op_probe &>::value)
+            return static_cast<const T &>(*any_access::unchecked_cast<T>(&arg));
+        else
+            return std::forward<Arg>(arg);
+    }
+
+    template<class Any, class Op, class Function = decltype(&Op::template apply<op_probe>)>
+    struct op_entry;
+
+    template<class Any, class Op, class R, class... Params>
+    struct op_entry<Any, Op, R (*)(const op_probe &, Params...)> {
+        R (*function)(const Any &, erased_param_t<Any, Params>...);
+
+        template<class T>
+        static R dispatch(const Any &operand, erased_param_t<Any, Params>... args) {
+            return Op::template apply<T>(*any_access::unchecked_cast<T>(&operand),
+                                         unerase<T, Any, Params>(std::forward<erased_param_t<Any, Params>>(args))...);
+        }
+    };
+
+    template<class Any, class... Ops>
+    struct ops_table : op_entry<Any, Ops>... {
+        const any_type_info *type;
+    };
+
+    template<class T, class Any, class... Ops>
+    constexpr ops_table<Any, Ops...> ops_table_for{{&op_entry<Any, Ops>::template dispatch<T>}..., &any_type_id<T>()};
+
+    template<class Op, class... Ops>
+    constexpr bool has_op = (std::is_same<Op, Ops>::value || ...);
+}
+
+template<class Any, class... Ops>
+class basic_poly {
+private:
+    using table_type = any_secret::ops_table<Any, Ops...>;
+
+    template<class ValueType>
+    static constexpr bool is_value = !std::is_same<std::decay_t<ValueType>, basic_poly>::value &&
+                                     any_secret::is_value_v<std::decay_t<ValueType>>;
+
+    Any storage;
+    const table_type *ops = nullptr;
+
+    template<class Op, class... Args>
+    decltype(auto) call_unchecked(Args &&...args) const {
+        return static_cast<const any_secret::op_entry<Any, Op> *>(ops)->function(storage, std::forward<Args>(args)...);
+    }
+
+    template<class OtherAny, class... OtherOps>
+    friend class basic_poly;
+
+    template<class T, class A, class... O>
+    friend const T *any_cast(const basic_poly<A, O...> *operand) noexcept;
+
+public:
+    using any_type = Any;
+
+    basic_poly() noexcept = default;
+
+    basic_poly(const basic_poly &other) = default;
+
+    basic_poly(basic_poly &&other) noexcept
+        : storage(std::move(other.storage)), ops(std::exchange(other.ops, nullptr))
+    {}
+
+    template<class ValueType, typename std::enable_if_t<is_value<ValueType>, int> = 0>
+    basic_poly(ValueType &&value)
+        : storage(std::forward<ValueType>(value)), ops(&any_secret::ops_table_for<std::decay_t<ValueType>, Any, Ops...>)
+    {}
+
+    template<class ValueType, class... Args>
+    explicit basic_poly(std::in_place_type_t<ValueType>, Args &&...args)
+        : storage(std::in_place_type<std::decay_t<ValueType>>, std::forward<Args>(args)...),
+          ops(&any_secret::ops_table_for<std::decay_t<ValueType>, Any, Ops...>)
+    {}
+
+    basic_poly &operator=(const basic_poly &rhs) {
+        basic_poly(rhs).swap(*this);
+        return *this;
+    }
+
+    basic_poly &operator=(basic_poly &&rhs) noexcept {
+        basic_poly(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    template<class ValueType, typename std::enable_if_t<is_value<ValueType>, int> = 0>
+    basic_poly &operator=(ValueType &&rhs) {
+        basic_poly(std::forward<ValueType>(rhs)).swap(*this);
+        return *this;
+    }
+
+    template<class ValueType, class... Args>
+    std::decay_t<ValueType> &emplace(Args &&...args) {
+        reset();
+        std::decay_t<ValueType> &value = storage.template emplace<std::decay_t<ValueType>>(std::forward<Args>(args)...);
+        ops = &any_secret::ops_table_for<std::decay_t<ValueType>, Any, Ops...>;
+        return value;
+    }
+
+    void reset() noexcept {
+        storage.reset();
+        ops = nullptr;
+    }
+
+    void swap(basic_poly &other) noexcept(noexcept(storage.swap(other.storage))) {
+        storage.swap(other.storage);
+        std::swap(ops, other.ops);
+    }
+
+    bool has_value() const noexcept {
+        return ops != nullptr;
+    }
+
+    const any_type_info &type() const noexcept {
+        return storage.type();
+    }
+
+    // the value as an Any, read-only so the table always matches the stored type
+    const Any &value() const noexcept {
+        return storage;
+    }
+
+    // applies Op to the value, throws bad_any_cast when empty
+    template<class Op, class... Args>
+    decltype(auto) call(Args &&...args) const {
+        static_assert(any_secret::has_op<Op, Ops...>, "Op shall be one of the operations of the basic_poly");
+        if (ops == nullptr)
+            throw bad_any_cast();
+        return call_unchecked<Op>(std::forward<Args>(args)...);
+    }
+
+    // tables are unique per stored type in the common case, the type comparison covers the others
+    bool same_type(const basic_poly &other) const noexcept {
+        return ops == other.ops || (ops != nullptr && other.ops != nullptr && *ops->type == *other.ops->type);
+    }
+
+    // 0 when empty
+    std::size_t hash() const {
+        return ops == nullptr ? 0 : call_unchecked<any_ops::hash>();
+    }
+};
+
+template<class... Ops>
+using poly = basic_poly<any, Ops...>;
+
+// the operators exist for the basic_polys whose Ops provide them
+template<class Any, class... Ops, typename std::enable_if_t<any_secret::has_op<any_ops::equal, Ops...>, int> = 0>
+bool operator==(const basic_poly<Any, Ops...> &lhs, const basic_poly<Any, Ops...> &rhs) {
+    if (!lhs.same_type(rhs))
+        return false;
+    return !lhs.has_value() || lhs.template call<any_ops::equal>(rhs.value());
+}
+
+template<class Any, class... Ops, typename std::enable_if_t<any_secret::has_op<any_ops::equal, Ops...>, int> = 0>
+bool operator!=(const basic_poly<Any, Ops...> &lhs, const basic_poly<Any, Ops...> &rhs) {
+    return !(lhs == rhs);
+}
+
+// empty values come first, values of different types are ordered by type name
+template<class Any, class... Ops, typename std::enable_if_t<any_secret::has_op<any_ops::less, Ops...>, int> = 0>
+bool operator<(const basic_poly<Any, Ops...> &lhs, const basic_poly<Any, Ops...> &rhs) {
+    if (lhs.same_type(rhs))
+        return lhs.has_value() && lhs.template call<any_ops::less>(rhs.value());
+    if (!lhs.has_value() || !rhs.has_value())
+        return !lhs.has_value();
+    return std::strcmp(lhs.type().name(), rhs.type().name()) < 0;
+}
+
+// prints nothing when empty
+template<class Any, class... Ops, typename std::enable_if_t<any_secret::has_op<any_ops::ostream, Ops...>, int> = 0>
+std::ostream &operator<<(std::ostream &os, const basic_poly<Any, Ops...> &operand) {
+    return operand.has_value() ? operand.template call<any_ops::ostream>(os) : os;
+}
+
+template<class T, class Any, class... Ops>
+const T *any_cast(const basic_poly<Any, Ops...> *operand) noexcept {
+    return operand == nullptr ? nullptr : any_cast<T>(&operand->storage);
+}
+
+template<class Any, class... Ops>
+void swap(basic_poly<Any, Ops...> &lhs, basic_poly<Any, Ops...> &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+namespace std {
+    template<class Any, class... Ops>
+    struct hash<basic_poly<Any, Ops...>> {
+        std::size_t operator()(const basic_poly<Any, Ops...> &operand) const {
+            static_assert(any_secret::has_op<any_ops::hash, Ops...>, "std::hash needs any_ops::hash");
+            return operand.hash();
+        }
+    };
+}
+
+#endif
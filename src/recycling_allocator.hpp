@@ -0,0 +1,273 @@
+#ifndef RECYCLING_ALLOCATOR_HPP
+#define RECYCLING_ALLOCATOR_HPP
+
+#include "any.hpp"
+#include "small_object_allocator.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// recycling_allocator<T, Upstream> keeps the blocks of the values it frees in a free list per type and per
+// thread, and hands them out again before asking Upstream. basic_any rebinds its allocator to the type of each
+// heap value, so a recycling_any reuses the block of a destroyed payload for the next payload of the same type
+// without going through new and delete.
+//
+// Each list keeps at most capacity() blocks and passes the others back to Upstream, trim() empties the list of
+// the calling thread and a thread gives its blocks back when it exits. Only single objects at least as large
+// as a pointer are recycled, other requests go straight to Upstream, which shall be stateless
+
+struct recycling_stats {
+    std::uint64_t hits;     // allocations served from a free list
+    std::uint64_t misses;   // allocations passed to Upstream
+    std::uint64_t recycled; // blocks kept in a free list
+    std::uint64_t released; // blocks passed back to Upstream, over capacity or trimmed
+
+    double hit_rate() const noexcept {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+    }
+};
+
+namespace recycling_secret {
+    constexpr std::size_t default_capacity = 64;
+
+    // a free block holds the address of the next one in its first bytes, copied since the block may be less
+    // aligned than a pointer
+    inline void *next_of(void *block) noexcept {
+        void *next;
+        std::memcpy(&next, block, sizeof(void *));
+        return next;
+    }
+
+    inline void link(void *block, void *next) noexcept {
+        std::memcpy(block, &next, sizeof(void *));
+    }
+
+    // the pools of the calling thread, linked so they can all be trimmed at once
+    struct pool_base {
+        pool_base *next;
+        void (*trim)(pool_base *pool) noexcept;
+    };
+
+    inline pool_base *&thread_pools() noexcept {
+        thread_local pool_base *head = nullptr;
+        return head;
+    }
+
+    template<class T, class Upstream>
+    class pool : public pool_base {
+    private:
+        using upstream_traits = typename std::allocator_traits<Upstream>::template rebind_traits<T>;
+
+        void *blocks = nullptr;
+        std::size_t count = 0;
+        recycling_stats local{};
+
+        // the counts of the threads that exited or trimmed
+        static inline std::atomic<std::uint64_t> hits{0};
+        static inline std::atomic<std::uint64_t> misses{0};
+        static inline std::atomic<std::uint64_t> recycled{0};
+        static inline std::atomic<std::uint64_t> released{0};
+
+        static void trim_pool(pool_base *base) noexcept {
+            static_cast<pool *>(base)->trim_blocks();
+        }
+
+        void fold() noexcept {
+            hits.fetch_add(local.hits, std::memory_order_relaxed);
+            misses.fetch_add(local.misses, std::memory_order_relaxed);
+            recycled.fetch_add(local.recycled, std::memory_order_relaxed);
+            released.fetch_add(local.released, std::memory_order_relaxed);
+            local = recycling_stats{};
+        }
+
+    public:
+        enum class state { unborn, alive, dead };
+
+        static inline std::atomic<std::size_t> capacity{default_capacity};
+
+        static state &current_state() noexcept {
+            thread_local state s = state::unborn;
+            return s;
+        }
+
+        static pool &local_pool() {
+            thread_local pool p;
+            return p;
+        }
+
+        static T *upstream_allocate(std::size_t n) {
+            typename upstream_traits::allocator_type upstream;
+            return upstream_traits::allocate(upstream, n);
+        }
+
+        static void upstream_deallocate(T *p, std::size_t n) noexcept {
+            typename upstream_traits::allocator_type upstream;
+            upstream_traits::deallocate(upstream, p, n);
+        }
+
+        pool() noexcept
+            : pool_base{thread_pools(), &trim_pool}
+        {
+            thread_pools() = this;
+            current_state() = state::alive;
+        }
+
+        pool(const pool &) = delete;
+        pool &operator=(const pool &) = delete;
+
+        ~pool() {
+            trim_blocks();
+            fold();
+
+            pool_base **link = &thread_pools();
+            while (*link != this)
+                link = &(*link)->next;
+            *link = next;
+
+            current_state() = state::dead;
+        }
+
+        T *allocate() {
+            if (blocks == nullptr) {
+                ++local.misses;
+                return upstream_allocate(1);
+            }
+
+            void *block = blocks;
+            blocks = next_of(block);
+            --count;
+            ++local.hits;
+            return static_cast<T *>(block);
+        }
+
+        void deallocate(T *p) noexcept {
+            if (count >= capacity.load(std::memory_order_relaxed)) {
+                ++local.released;
+                upstream_deallocate(p, 1);
+                return;
+            }
+
+            link(p, blocks);
+            blocks = p;
+            ++count;
+            ++local.recycled;
+        }
+
+        void trim_blocks() noexcept {
+            while (blocks != nullptr) {
+                void *block = blocks;
+                blocks = next_of(block);
+                upstream_deallocate(static_cast<T *>(block), 1);
+                ++local.released;
+            }
+            count = 0;
+        }
+
+        std::size_t size() const noexcept {
+            return count;
+        }
+
+        static recycling_stats totals() noexcept {
+            recycling_stats stats = {hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed),
+                                     recycled.load(std::memory_order_relaxed), released.load(std::memory_order_relaxed)};
+            if (current_state() == state::alive) {
+                const recycling_stats &own = local_pool().local;
+                stats.hits += own.hits;
+                stats.misses += own.misses;
+                stats.recycled += own.recycled;
+                stats.released += own.released;
+            }
+            return stats;
+        }
+    };
+}
+
+template<class T, class Upstream = small_object_allocator<T>>
+class recycling_allocator {
+private:
+    using pool = recycling_secret::pool<T, Upstream>;
+
+    static constexpr bool recyclable = sizeof(T) >= sizeof(void *);
+
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind {
+        using other = recycling_allocator<U, typename std::allocator_traits<Upstream>::template rebind_alloc<U>>;
+    };
+
+    constexpr recycling_allocator() noexcept = default;
+
+    template<class U, class OtherUpstream>
+    constexpr recycling_allocator(const recycling_allocator<U, OtherUpstream> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        if (n != 1 || !recyclable || pool::current_state() == pool::state::dead)
+            return pool::upstream_allocate(n);
+        return pool::local_pool().allocate();
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        // blocks released while the thread is shutting down go straight to Upstream
+        if (n != 1 || !recyclable || pool::current_state() == pool::state::dead)
+            pool::upstream_deallocate(p, n);
+        else
+            pool::local_pool().deallocate(p);
+    }
+
+    // the most blocks of T each thread keeps, default_capacity unless set
+    static std::size_t capacity() noexcept {
+        return pool::capacity.load(std::memory_order_relaxed);
+    }
+
+    static void set_capacity(std::size_t blocks) noexcept {
+        pool::capacity.store(blocks, std::memory_order_relaxed);
+    }
+
+    // the number of blocks of T kept by the calling thread
+    static std::size_t cached() noexcept {
+        return pool::current_state() == pool::state::alive ? pool::local_pool().size() : 0;
+    }
+
+    // passes the blocks of T kept by the calling thread back to Upstream
+    static void trim() noexcept {
+        if (pool::current_state() == pool::state::alive)
+            pool::local_pool().trim_blocks();
+    }
+
+    // the counts of T over the threads that exited and the calling thread
+    static recycling_stats stats() noexcept {
+        return pool::totals();
+    }
+};
+
+template<class T, class U, class TU, class UU>
+constexpr bool operator==(const recycling_allocator<T, TU> &, const recycling_allocator<U, UU> &) noexcept {
+    return true;
+}
+
+template<class T, class U, class TU, class UU>
+constexpr bool operator!=(const recycling_allocator<T, TU> &, const recycling_allocator<U, UU> &) noexcept {
+    return false;
+}
+
+// passes the blocks of every type kept by the calling thread back to Upstream
+inline void trim_recycling_allocators() noexcept {
+    for (recycling_secret::pool_base *p = recycling_secret::thread_pools(); p != nullptr; p = p->next)
+        p->trim(p);
+}
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Upstream = small_object_allocator<std::byte>>
+using basic_recycling_any = basic_any<InlineSize, InlineAlign, recycling_allocator<std::byte, Upstream>>;
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Upstream = small_object_allocator<std::byte>>
+using basic_recycling_unique_any = basic_unique_any<InlineSize, InlineAlign, recycling_allocator<std::byte, Upstream>>;
+
+using recycling_any = basic_recycling_any<2*sizeof(void*), alignof(void*)>;
+using recycling_unique_any = basic_recycling_unique_any<2*sizeof(void*), alignof(void*)>;
+
+#endif
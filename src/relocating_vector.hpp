@@ -0,0 +1,212 @@
+#ifndef RELOCATING_VECTOR_HPP
+#define RELOCATING_VECTOR_HPP
+
+#include "relocation.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// vector that grows trivially relocatable elements with realloc instead of moving them one by one.
+// Other elements are moved when their move constructor cannot throw and copied otherwise
+template<class T>
+class relocating_vector {
+private:
+    static constexpr bool use_realloc = is_trivially_relocatable_v<T> && alignof(T) <= alignof(std::max_align_t);
+
+    T *elements;
+    std::size_t count;
+    std::size_t allocated;
+
+    static T *allocate(std::size_t n) {
+        if constexpr (use_realloc) {
+            void *memory = std::malloc(n * sizeof(T));
+            if (memory == nullptr)
+                throw std::bad_alloc();
+            return static_cast<T *>(memory);
+        }
+        else
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    static void deallocate(T *p) noexcept {
+        if constexpr (use_realloc)
+            std::free(p);
+        else
+            ::operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    void grow(std::size_t n) {
+        if constexpr (use_realloc) {
+            void *memory = std::realloc(static_cast<void *>(elements), n * sizeof(T));
+            if (memory == nullptr)
+                throw std::bad_alloc();
+            elements = static_cast<T *>(memory);
+        }
+        else {
+            T *grown = allocate(n);
+            std::size_t i = 0;
+            try {
+                for (; i < count; ++i) {
+                    if constexpr (is_trivially_relocatable_v<T>)
+                        std::memcpy(static_cast<void *>(grown + i), elements + i, sizeof(T));
+                    else
+                        new (grown + i) T(std::move_if_noexcept(elements[i]));
+                }
+            }
+            catch (...) {
+                for (std::size_t j = 0; j < i; ++j)
+                    grown[j].~T();
+                deallocate(grown);
+                throw;
+            }
+
+            if constexpr (!is_trivially_relocatable_v<T>) {
+                for (std::size_t j = 0; j < count; ++j)
+                    elements[j].~T();
+            }
+            deallocate(elements);
+            elements = grown;
+        }
+
+        allocated = n;
+    }
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    relocating_vector() noexcept
+        : elements{nullptr}, count{0}, allocated{0}
+    {}
+
+    relocating_vector(const relocating_vector &other)
+        : relocating_vector()
+    {
+        reserve(other.count);
+        for (const T &value : other)
+            push_back(value);
+    }
+
+    relocating_vector(relocating_vector &&other) noexcept
+        : elements{other.elements}, count{other.count}, allocated{other.allocated}
+    {
+        other.elements = nullptr;
+        other.count = 0;
+        other.allocated = 0;
+    }
+
+    relocating_vector &operator=(relocating_vector rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    ~relocating_vector() {
+        clear();
+        deallocate(elements);
+    }
+
+    void swap(relocating_vector &other) noexcept {
+        std::swap(elements, other.elements);
+        std::swap(count, other.count);
+        std::swap(allocated, other.allocated);
+    }
+
+    void reserve(std::size_t n) {
+        if (n > allocated)
+            grow(n);
+    }
+
+    template<class... Args>
+    T &emplace_back(Args &&...args) {
+        if (count == allocated) {
+            // construct first, args may refer to an element that moves when the buffer grows
+            T value(std::forward<Args>(args)...);
+            grow(allocated == 0 ? 4 : 2 * allocated);
+            new (elements + count) T(std::move(value));
+        }
+        else
+            new (elements + count) T(std::forward<Args>(args)...);
+
+        return elements[count++];
+    }
+
+    void push_back(const T &value) {
+        emplace_back(value);
+    }
+
+    void push_back(T &&value) {
+        emplace_back(std::move(value));
+    }
+
+    void pop_back() noexcept {
+        elements[--count].~T();
+    }
+
+    void clear() noexcept {
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            for (std::size_t i = 0; i < count; ++i)
+                elements[i].~T();
+        }
+        count = 0;
+    }
+
+    T &operator[](std::size_t i) noexcept {
+        return elements[i];
+    }
+
+    const T &operator[](std::size_t i) const noexcept {
+        return elements[i];
+    }
+
+    T &back() noexcept {
+        return elements[count - 1];
+    }
+
+    const T &back() const noexcept {
+        return elements[count - 1];
+    }
+
+    T *data() noexcept {
+        return elements;
+    }
+
+    const T *data() const noexcept {
+        return elements;
+    }
+
+    std::size_t size() const noexcept {
+        return count;
+    }
+
+    std::size_t capacity() const noexcept {
+        return allocated;
+    }
+
+    bool empty() const noexcept {
+        return count == 0;
+    }
+
+    iterator begin() noexcept {
+        return elements;
+    }
+
+    iterator end() noexcept {
+        return elements + count;
+    }
+
+    const_iterator begin() const noexcept {
+        return elements;
+    }
+
+    const_iterator end() const noexcept {
+        return elements + count;
+    }
+};
+
+#endif
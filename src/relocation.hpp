@@ -0,0 +1,15 @@
+#ifndef RELOCATION_HPP
+#define RELOCATION_HPP
+
+#include <type_traits>
+
+// A type is trivially relocatable when moving an object to a new address and destroying the original can
+// be replaced by copying its bytes. Trivially copyable types always are, other types opt in by
+// specializing is_trivially_relocatable
+template<class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<class T>
+constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+#endif
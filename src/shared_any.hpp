@@ -0,0 +1,181 @@
+#ifndef SHARED_ANY_HPP
+#define SHARED_ANY_HPP
+
+#include "any.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// shared_any is a basic_any whose heap values live in reference counted blocks. Copying a shared_any shares
+// the block, writing through any_cast on a non-const shared_any copies the value first when the block is
+// shared. Assigning a value of the held type to a shared value makes a new block instead. Values stored
+// inline are copied as usual.
+//
+// A reference from a non-const any_cast may be kept and written through later, so its block is never shared
+// again: copies of that shared_any copy the value. const casts leave the block shareable
+
+// selects the shared heap path of basic_any, allocations are made with Alloc
+template<class Alloc>
+class shared_any_allocator : public Alloc {
+public:
+    template<class U>
+    struct rebind {
+        using other = shared_any_allocator<typename std::allocator_traits<Alloc>::template rebind_alloc<U>>;
+    };
+
+    using Alloc::Alloc;
+
+    shared_any_allocator() = default;
+
+    shared_any_allocator(const Alloc &alloc) noexcept
+        : Alloc(alloc)
+    {}
+
+    template<class OtherAlloc>
+    shared_any_allocator(const shared_any_allocator<OtherAlloc> &alloc) noexcept
+        : Alloc(static_cast<const OtherAlloc &>(alloc))
+    {}
+};
+
+namespace any_secret {
+    // the block keeps the allocator it was made with, so whichever any releases it last can free it
+    template<class ValueType, class Alloc>
+    struct vtable_heap<ValueType, shared_any_allocator<Alloc>> {
+        using value_traits = typename std::allocator_traits<Alloc>::template rebind_traits<ValueType>;
+
+        // the value comes first so the heap pointer of the any points to it. A block is unshareable once its
+        // value was handed out for writing
+        struct block {
+            ValueType value;
+            std::atomic<std::size_t> references;
+            Alloc allocator;
+            bool unshareable;
+        };
+
+        using block_traits = typename std::allocator_traits<Alloc>::template rebind_traits<block>;
+
+        static ValueType *object(const void *storage) noexcept {
+            return *reinterpret_cast<ValueType *const *>(storage);
+        }
+
+        static block *owner(const void *storage) noexcept {
+            return reinterpret_cast<block *>(object(storage));
+        }
+
+        template<class... Args>
+        static ValueType *create(const Alloc &allocator, Args &&...args) {
+            typename block_traits::allocator_type block_alloc(allocator);
+            block *b = block_traits::allocate(block_alloc, 1);
+            try {
+                typename value_traits::allocator_type value_alloc(allocator);
+                value_traits::construct(value_alloc, &b->value, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                block_traits::deallocate(block_alloc, b, 1);
+                throw;
+            }
+
+            new (&b->references) std::atomic<std::size_t>(1);
+            new (&b->allocator) Alloc(allocator);
+            b->unshareable = false;
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::heap_allocations));
+            ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::bytes_allocated, sizeof(block)));
+            return &b->value;
+        }
+
+        static void release(block *b) noexcept {
+            if (b->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            Alloc allocator(std::move(b->allocator));
+            b->allocator.~Alloc();
+            b->references.~atomic();
+
+            typename value_traits::allocator_type value_alloc(allocator);
+            value_traits::destroy(value_alloc, &b->value);
+
+            typename block_traits::allocator_type block_alloc(allocator);
+            block_traits::deallocate(block_alloc, b, 1);
+        }
+
+        static void move(void *src, void *dest) noexcept {
+            *reinterpret_cast<void **>(dest) = object(src);
+            *reinterpret_cast<void **>(src) = nullptr;
+        }
+
+        static void copy(const void *src, void *dest, const void *) {
+            block *b = owner(src);
+            if (b->unshareable) {
+                if constexpr (std::is_copy_constructible<ValueType>::value)
+                    *reinterpret_cast<void **>(dest) = create(b->allocator, std::as_const(b->value));
+                return;
+            }
+
+            b->references.fetch_add(1, std::memory_order_relaxed);
+            *reinterpret_cast<void **>(dest) = object(src);
+        }
+
+        static void destroy(void *storage, const void *) noexcept {
+            release(owner(storage));
+            *reinterpret_cast<void **>(storage) = nullptr;
+        }
+
+        // a sole owner writes in place, the others first copy the value into a block of their own
+        static void unshare(void *storage) {
+            block *b = owner(storage);
+            if (b->references.load(std::memory_order_acquire) != 1) {
+                if constexpr (std::is_copy_constructible<ValueType>::value) {
+                    *reinterpret_cast<void **>(storage) = create(b->allocator, std::as_const(b->value));
+                    release(b);
+                }
+            }
+
+            owner(storage)->unshareable = true;
+        }
+
+        static bool exclusive(const void *storage) noexcept {
+            return owner(storage)->references.load(std::memory_order_acquire) == 1;
+        }
+
+        static const vtable_storage *convert(void *src, void *dest, std::size_t inline_size, std::size_t inline_align,
+                                             const void *, const void *)
+        {
+            if constexpr (std::is_nothrow_move_constructible<ValueType>::value) {
+                if (fits_inline<ValueType>(inline_size, inline_align)) {
+                    block *b = owner(src);
+                    if (b->references.load(std::memory_order_acquire) == 1)
+                        new (dest) ValueType(std::move(b->value));
+                    else if constexpr (std::is_copy_constructible<ValueType>::value)
+                        new (dest) ValueType(std::as_const(b->value));
+                    ANY_INSTRUMENT(any_instrumentation::count<ValueType>(&counters_t::inline_placements));
+
+                    destroy(src, nullptr);
+                    return &vtable_stack<ValueType, shared_any_allocator<Alloc>>::vtable;
+                }
+            }
+
+            move(src, dest);
+            return &vtable;
+        }
+
+        static constexpr vtable_t<ValueType> vtable = make_vtable<ValueType>(false, true, false, move, copy, destroy, convert);
+    };
+}
+
+template<std::size_t InlineSize, std::size_t InlineAlign, class Alloc = small_object_allocator<std::byte>>
+using basic_shared_any = basic_any<InlineSize, InlineAlign, shared_any_allocator<Alloc>>;
+
+using shared_any = basic_shared_any<2*sizeof(void*), alignof(void*)>;
+
+namespace pmr {
+    template<std::size_t InlineSize, std::size_t InlineAlign>
+    using basic_shared_any = ::basic_shared_any<InlineSize, InlineAlign, std::pmr::polymorphic_allocator<std::byte>>;
+
+    using shared_any = basic_shared_any<2*sizeof(void*), alignof(void*)>;
+}
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef SMALL_OBJECT_ALLOCATOR_HPP
+#define SMALL_OBJECT_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+// The small object allocator described in Modern C++ Design by Andrei Alexandrescu, reworked for threads.
+// Objects up to max_small_object_size bytes are served from fixed size blocks carved out of chunks, one
+// size class per block_alignment bytes. Each thread keeps a free list per size class, blocks move between
+// threads in batches through a lock-free list per size class. Chunks are never returned to the system.
+
+namespace small_object_secret {
+    constexpr std::size_t block_alignment = alignof(std::max_align_t) < 16 ? 16 : alignof(std::max_align_t);
+    constexpr std::size_t max_small_object_size = 256;
+    constexpr std::size_t size_classes = max_small_object_size / block_alignment;
+    constexpr std::size_t chunk_bytes = 16 * 1024;
+    constexpr std::size_t batch_size = 32;
+
+    // a block waiting to be reused. The first block of a batch links to the next batch
+    struct free_block {
+        free_block *next;
+        free_block *next_batch;
+    };
+
+    struct alignas(block_alignment) chunk_header {
+        chunk_header *next;
+    };
+
+    constexpr std::size_t size_class(std::size_t size) noexcept {
+        return size == 0 ? 0 : (size - 1) / block_alignment;
+    }
+
+    constexpr std::size_t block_size(std::size_t size_class) noexcept {
+        return (size_class + 1) * block_alignment;
+    }
+
+    // the blocks of one size class shared by every thread. Batches are pushed with a compare-exchange and
+    // taken all at once with an exchange, so no thread ever pops a single node and the list is free of ABA
+    class fixed_allocator {
+    private:
+        std::atomic<free_block *> batches;
+        std::atomic<std::size_t> chunks;
+
+    public:
+        constexpr fixed_allocator() noexcept : batches{nullptr}, chunks{0} {}
+
+        // push the batches first ... last, already linked through next_batch
+        void push(free_block *first, free_block *last) noexcept {
+            free_block *head = batches.load(std::memory_order_relaxed);
+            do {
+                last->next_batch = head;
+            } while (!batches.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // take every batch at once
+        free_block *take_all() noexcept {
+            return batches.exchange(nullptr, std::memory_order_acquire);
+        }
+
+        // carve a new chunk into batches of blocks linked through next_batch
+        free_block *allocate_chunk(std::size_t size_class);
+
+        std::size_t chunk_count() const noexcept {
+            return chunks.load(std::memory_order_relaxed);
+        }
+    };
+
+    inline std::atomic<chunk_header *> chunk_registry{nullptr};
+
+    inline fixed_allocator fixed_allocators[size_classes];
+
+    inline free_block *fixed_allocator::allocate_chunk(std::size_t size_class) {
+        const std::size_t size = block_size(size_class);
+        const std::size_t blocks = (chunk_bytes - sizeof(chunk_header)) / size;
+
+        // chunks stay reachable from the registry for the lifetime of the program
+        chunk_header *chunk = static_cast<chunk_header *>(::operator new(chunk_bytes));
+        chunk->next = chunk_registry.load(std::memory_order_relaxed);
+        while (!chunk_registry.compare_exchange_weak(chunk->next, chunk, std::memory_order_release, std::memory_order_relaxed));
+        chunks.fetch_add(1, std::memory_order_relaxed);
+
+        unsigned char *memory = reinterpret_cast<unsigned char *>(chunk + 1);
+        free_block *first_batch = nullptr;
+        free_block *last_batch = nullptr;
+        for (std::size_t i = 0; i < blocks; i += batch_size) {
+            const std::size_t end = i + batch_size < blocks ? i + batch_size : blocks;
+            free_block *batch = reinterpret_cast<free_block *>(memory + i * size);
+            for (std::size_t j = i; j < end; ++j) {
+                free_block *block = reinterpret_cast<free_block *>(memory + j * size);
+                block->next = j + 1 < end ? reinterpret_cast<free_block *>(memory + (j + 1) * size) : nullptr;
+            }
+
+            batch->next_batch = nullptr;
+            if (last_batch != nullptr)
+                last_batch->next_batch = batch;
+            else
+                first_batch = batch;
+            last_batch = batch;
+        }
+
+        return first_batch;
+    }
+
+    // per thread free lists, drained one batch at a time. Batches taken from the shared list or a new chunk
+    // wait in the reserve until the free list runs dry
+    class thread_cache {
+    private:
+        free_block *blocks[size_classes] = {};
+        std::size_t counts[size_classes] = {};
+        free_block *reserve[size_classes] = {};
+
+        static void release_batch(std::size_t size_class, free_block *&blocks, std::size_t &count, std::size_t size) noexcept {
+            free_block *first = blocks;
+            free_block *last = first;
+            for (std::size_t i = 1; i < size; ++i)
+                last = last->next;
+
+            blocks = last->next;
+            count -= size;
+            last->next = nullptr;
+            fixed_allocators[size_class].push(first, first);
+        }
+
+    public:
+        enum class state { unborn, alive, dead };
+
+        static state &current_state() noexcept {
+            thread_local state s = state::unborn;
+            return s;
+        }
+
+        thread_cache() noexcept {
+            current_state() = state::alive;
+        }
+
+        thread_cache(const thread_cache &) = delete;
+        thread_cache &operator=(const thread_cache &) = delete;
+
+        ~thread_cache() {
+            for (std::size_t i = 0; i < size_classes; ++i) {
+                while (counts[i] > 0)
+                    release_batch(i, blocks[i], counts[i], counts[i] < batch_size ? counts[i] : batch_size);
+
+                if (reserve[i] != nullptr) {
+                    free_block *last = reserve[i];
+                    while (last->next_batch != nullptr)
+                        last = last->next_batch;
+                    fixed_allocators[i].push(reserve[i], last);
+                }
+            }
+
+            current_state() = state::dead;
+        }
+
+        void *allocate(std::size_t size_class) {
+            free_block *block = blocks[size_class];
+            if (block == nullptr) {
+                if (reserve[size_class] == nullptr)
+                    reserve[size_class] = fixed_allocators[size_class].take_all();
+                if (reserve[size_class] == nullptr)
+                    reserve[size_class] = fixed_allocators[size_class].allocate_chunk(size_class);
+
+                block = reserve[size_class];
+                reserve[size_class] = block->next_batch;
+
+                std::size_t count = 0;
+                for (free_block *b = block; b != nullptr; b = b->next)
+                    ++count;
+                counts[size_class] = count;
+            }
+
+            blocks[size_class] = block->next;
+            --counts[size_class];
+            return block;
+        }
+
+        void deallocate(void *p, std::size_t size_class) noexcept {
+            free_block *block = static_cast<free_block *>(p);
+            block->next = blocks[size_class];
+            blocks[size_class] = block;
+
+            if (++counts[size_class] >= 2 * batch_size)
+                release_batch(size_class, blocks[size_class], counts[size_class], batch_size);
+        }
+    };
+
+    inline thread_cache &local_cache() {
+        thread_local thread_cache cache;
+        return cache;
+    }
+
+    inline void *allocate(std::size_t size, std::size_t alignment) {
+        if (size > max_small_object_size || alignment > block_alignment)
+            return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ?
+                ::operator new(size, std::align_val_t(alignment)) :
+                ::operator new(size);
+
+        // the cache of a thread shutting down is gone, so blocks come straight from operator new. They are
+        // full blocks of their size class, as deallocate may hand them to the shared list like any other
+        if (thread_cache::current_state() == thread_cache::state::dead)
+            return ::operator new(block_size(size_class(size)));
+
+        return local_cache().allocate(size_class(size));
+    }
+
+    inline void deallocate(void *p, std::size_t size, std::size_t alignment) noexcept {
+        if (size > max_small_object_size || alignment > block_alignment) {
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(p, std::align_val_t(alignment));
+            else
+                ::operator delete(p);
+            return;
+        }
+
+        // blocks released while the thread is shutting down go straight to the shared list
+        if (thread_cache::current_state() == thread_cache::state::dead) {
+            free_block *block = static_cast<free_block *>(p);
+            block->next = nullptr;
+            fixed_allocators[size_class(size)].push(block, block);
+            return;
+        }
+
+        local_cache().deallocate(p, size_class(size));
+    }
+}
+
+// stateless allocator serving small objects from the pools above and larger ones from operator new
+template<class T>
+class small_object_allocator {
+public:
+    using value_type = T;
+
+    constexpr small_object_allocator() noexcept = default;
+
+    template<class U>
+    constexpr small_object_allocator(const small_object_allocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(small_object_secret::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        small_object_secret::deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    // number of chunks carved so far for objects of the given size
+    static std::size_t chunk_count(std::size_t size) noexcept {
+        if (size > small_object_secret::max_small_object_size)
+            return 0;
+        return small_object_secret::fixed_allocators[small_object_secret::size_class(size)].chunk_count();
+    }
+};
+
+template<class T, class U>
+constexpr bool operator==(const small_object_allocator<T> &, const small_object_allocator<U> &) noexcept {
+    return true;
+}
+
+template<class T, class U>
+constexpr bool operator!=(const small_object_allocator<T> &, const small_object_allocator<U> &) noexcept {
+    return false;
+}
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef VARIANT_HPP
+#define VARIANT_HPP
+
+#include "type_lists.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace TL {
+
+// variant over the types of a type_list. The buffer is as large and as aligned as the largest member and the
+// discriminator is the smallest unsigned integer holding every index plus the empty state. Copies, moves,
+// destruction and visitation go through tables indexed by the discriminator. A variant is empty when default
+// constructed, after reset, after being moved from and when constructing a value into it throws. Copying
+// needs every type to be copy constructible
+template<typename List>
+class variant;
+
+namespace variant_secret {
+    template<unsigned Count>
+    using index_type = std::conditional_t<Count < 0xff, unsigned char,
+                       std::conditional_t<Count < 0xffff, unsigned short, unsigned>>;
+}
+
+template<template<typename...> typename Va, typename... Ts>
+class variant<Va<Ts...>> {
+    static_assert(sizeof...(Ts) > 0, "the type_list shall not be empty");
+    static_assert(((!std::is_reference_v<Ts> && !std::is_void_v<Ts> && !std::is_array_v<Ts>) && ...),
+                  "the types shall be object types other than arrays");
+
+public:
+    using types = Va<Ts...>;
+
+    static constexpr unsigned size = length<types>::value;
+
+    // index of the empty state
+    static constexpr unsigned npos = size;
+
+    // position of T in the type_list, -1 when it is not a member
+    template<typename T>
+    static constexpr int index_of_v = index_of<std::decay_t<T>, types>::value;
+
+private:
+    using discriminator_type = variant_secret::index_type<size>;
+
+    static constexpr std::size_t buffer_size = std::max({sizeof(Ts)...});
+
+    static constexpr bool trivially_copyable = (std::is_trivially_copyable_v<Ts> && ...);
+    static constexpr bool trivially_destructible = (std::is_trivially_destructible_v<Ts> && ...);
+    static constexpr bool nothrow_move = (std::is_nothrow_move_constructible_v<Ts> && ...);
+
+    alignas(Ts...) unsigned char buffer[buffer_size];
+    discriminator_type discriminator = npos;
+
+    template<typename T>
+    static void copy_one(const void *src, void *dest) {
+        new (dest) T(*static_cast<const T *>(src));
+    }
+
+    template<typename T>
+    static void move_one(void *src, void *dest) noexcept(nothrow_move) {
+        new (dest) T(std::move(*static_cast<T *>(src)));
+        static_cast<T *>(src)->~T();
+    }
+
+    template<typename T>
+    static void destroy_one(void *storage) noexcept {
+        static_cast<T *>(storage)->~T();
+    }
+
+    template<typename T, typename Result, typename Storage, typename Visitor>
+    static Result visit_one(Storage *storage, Visitor &visitor) {
+        using value_type = std::conditional_t<std::is_const_v<Storage>, const T, T>;
+        return std::forward<Visitor>(visitor)(*std::launder(reinterpret_cast<value_type *>(storage)));
+    }
+
+    template<typename Storage, typename Visitor>
+    static decltype(auto) visit_storage(Storage *storage, unsigned index, Visitor &visitor) {
+        using first = std::conditional_t<std::is_const_v<Storage>, const typename get<0, types>::type, typename get<0, types>::type>;
+        using result = decltype(std::declval<Visitor>()(std::declval<first &>()));
+        using handler = result (*)(Storage *, Visitor &);
+
+        static constexpr handler handlers[] = {&visit_one<Ts, result, Storage, Visitor>...};
+        if (index == npos)
+            throw std::bad_variant_access();
+        return handlers[index](storage, visitor);
+    }
+
+    void copy_from(const variant &other) {
+        if (other.discriminator == npos)
+            return;
+
+        if constexpr (trivially_copyable)
+            std::memcpy(buffer, other.buffer, buffer_size);
+        else {
+            using copier = void (*)(const void *, void *);
+            static constexpr copier copiers[] = {&copy_one<Ts>...};
+            copiers[other.discriminator](other.buffer, buffer);
+        }
+        discriminator = other.discriminator;
+    }
+
+    void move_from(variant &other) noexcept(nothrow_move) {
+        if (other.discriminator == npos)
+            return;
+
+        if constexpr (trivially_copyable)
+            std::memcpy(buffer, other.buffer, buffer_size);
+        else {
+            using mover = void (*)(void *, void *);
+            static constexpr mover movers[] = {&move_one<Ts>...};
+            movers[other.discriminator](other.buffer, buffer);
+        }
+        discriminator = std::exchange(other.discriminator, static_cast<discriminator_type>(npos));
+    }
+
+public:
+    variant() noexcept = default;
+
+    template<typename T, typename std::enable_if_t<index_of<std::decay_t<T>, types>::value != -1, int> = 0>
+    variant(T &&value) {
+        emplace<std::decay_t<T>>(std::forward<T>(value));
+    }
+
+    template<typename T, typename... Args>
+    explicit variant(std::in_place_type_t<T>, Args &&...args) {
+        emplace<T>(std::forward<Args>(args)...);
+    }
+
+    variant(const variant &other) {
+        copy_from(other);
+    }
+
+    variant(variant &&other) noexcept(nothrow_move) {
+        move_from(other);
+    }
+
+    variant &operator=(const variant &rhs) {
+        if (this != &rhs) {
+            reset();
+            copy_from(rhs);
+        }
+        return *this;
+    }
+
+    variant &operator=(variant &&rhs) noexcept(nothrow_move) {
+        if (this != &rhs) {
+            reset();
+            move_from(rhs);
+        }
+        return *this;
+    }
+
+    template<typename T, typename std::enable_if_t<index_of<std::decay_t<T>, types>::value != -1, int> = 0>
+    variant &operator=(T &&value) {
+        if (holds<std::decay_t<T>>())
+            *get_if<std::decay_t<T>>() = std::forward<T>(value);
+        else
+            emplace<std::decay_t<T>>(std::forward<T>(value));
+        return *this;
+    }
+
+    ~variant() {
+        reset();
+    }
+
+    template<typename T, typename... Args>
+    T &emplace(Args &&...args) {
+        static_assert(index_of_v<T> != -1, "T shall be one of the types of the variant");
+        reset();
+        T *value = new (buffer) T(std::forward<Args>(args)...);
+        discriminator = static_cast<discriminator_type>(index_of_v<T>);
+        return *value;
+    }
+
+    void reset() noexcept {
+        if constexpr (!trivially_destructible) {
+            if (discriminator != npos) {
+                using destroyer = void (*)(void *);
+                static constexpr destroyer destroyers[] = {&destroy_one<Ts>...};
+                destroyers[discriminator](buffer);
+            }
+        }
+        discriminator = npos;
+    }
+
+    void swap(variant &other) noexcept(nothrow_move) {
+        variant tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    bool has_value() const noexcept {
+        return discriminator != npos;
+    }
+
+    // position in the type_list of the held type, npos when empty
+    unsigned index() const noexcept {
+        return discriminator;
+    }
+
+    template<typename T>
+    bool holds() const noexcept {
+        static_assert(index_of_v<T> != -1, "T shall be one of the types of the variant");
+        return discriminator == index_of_v<T>;
+    }
+
+    template<typename T>
+    T *get_if() noexcept {
+        return holds<T>() ? std::launder(reinterpret_cast<T *>(buffer)) : nullptr;
+    }
+
+    template<typename T>
+    const T *get_if() const noexcept {
+        return holds<T>() ? std::launder(reinterpret_cast<const T *>(buffer)) : nullptr;
+    }
+
+    // throws std::bad_variant_access when the variant does not hold a T
+    template<typename T>
+    T &get() {
+        if (!holds<T>())
+            throw std::bad_variant_access();
+        return *get_if<T>();
+    }
+
+    template<typename T>
+    const T &get() const {
+        if (!holds<T>())
+            throw std::bad_variant_access();
+        return *get_if<T>();
+    }
+
+    // calls visitor with a reference to the held value, throws std::bad_variant_access when empty. The
+    // visitor shall return the same type for every member
+    template<typename Visitor>
+    decltype(auto) visit(Visitor &&visitor) {
+        return visit_storage<unsigned char, Visitor>(buffer, discriminator, visitor);
+    }
+
+    template<typename Visitor>
+    decltype(auto) visit(Visitor &&visitor) const {
+        return visit_storage<const unsigned char, Visitor>(buffer, discriminator, visitor);
+    }
+};
+
+template<typename T, typename List>
+T *get_if(variant<List> *operand) noexcept {
+    return operand == nullptr ? nullptr : operand->template get_if<T>();
+}
+
+template<typename T, typename List>
+const T *get_if(const variant<List> *operand) noexcept {
+    return operand == nullptr ? nullptr : operand->template get_if<T>();
+}
+
+template<typename List, typename Visitor>
+decltype(auto) visit(Visitor &&visitor, variant<List> &operand) {
+    return operand.visit(std::forward<Visitor>(visitor));
+}
+
+template<typename List, typename Visitor>
+decltype(auto) visit(Visitor &&visitor, const variant<List> &operand) {
+    return operand.visit(std::forward<Visitor>(visitor));
+}
+
+template<typename List>
+void swap(variant<List> &lhs, variant<List> &rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+}
+
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "lib/catch.hpp"
+#include "src/any.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace {
+    struct small {
+        int i;
+    };
+
+    struct large {
+        char raw[64];
+    };
+
+    struct never_stored {};
+
+    const any_instrumentation::type_stats *find(const std::vector<any_instrumentation::type_stats> &stats,
+                                                const any_type_info &type) {
+        for (const any_instrumentation::type_stats &s : stats) {
+            if (*s.type == type)
+                return &s;
+        }
+        return nullptr;
+    }
+}
+
+TEST_CASE("any instrumentation tests") {
+    any_instrumentation::reset();
+
+    // inline values
+    any small_any = small{1};
+    any cp_small_any = small_any;
+    any mv_small_any = std::move(cp_small_any);
+
+    any_instrumentation::type_stats small_stats = any_instrumentation::stats_of<small>();
+    REQUIRE(small_stats.constructions == 1);
+    REQUIRE(small_stats.copies == 1);
+    REQUIRE(small_stats.moves == 1);
+    REQUIRE(small_stats.inline_placements == 2);
+    REQUIRE(small_stats.heap_allocations == 0);
+    REQUIRE(small_stats.bytes_allocated == 0);
+
+    // heap values
+    any large_any = large{"this is a raw string"};
+    any cp_large_any = large_any;
+    large_any.emplace<large>();
+
+    any_instrumentation::type_stats large_stats = any_instrumentation::stats_of<large>();
+    REQUIRE(large_stats.constructions == 2);
+    REQUIRE(large_stats.copies == 1);
+    REQUIRE(large_stats.heap_allocations == 3);
+    REQUIRE(large_stats.bytes_allocated == 3 * sizeof(large));
+    REQUIRE(large_stats.inline_placements == 0);
+
+    // failed casts are counted for the requested type
+    REQUIRE(any_cast<std::string>(&small_any) == nullptr);
+    REQUIRE_THROWS_AS(any_cast<std::string>(large_any), bad_any_cast);
+    REQUIRE(any_instrumentation::stats_of<std::string>().failed_casts == 2);
+
+    // the snapshot lists the types seen since the start of the program
+    std::vector<any_instrumentation::type_stats> stats = any_instrumentation::snapshot();
+    REQUIRE(find(stats, any_type_id<small>()) != nullptr);
+    REQUIRE(find(stats, any_type_id<large>())->heap_allocations == 3);
+    REQUIRE(find(stats, any_type_id<never_stored>()) == nullptr);
+
+    any_instrumentation::reset();
+    REQUIRE(any_instrumentation::stats_of<large>().heap_allocations == 0);
+}
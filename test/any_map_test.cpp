@@ -0,0 +1,127 @@
+#include "lib/catch.hpp"
+#include "src/any_map.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct deadline {
+        long milliseconds;
+    };
+
+    struct trace {
+        std::string id;
+        std::vector<std::string> spans;
+    };
+
+    template<int N>
+    struct property {
+        int value;
+    };
+
+    // large enough to be stored on the heap
+    struct fragile {
+        long payload[8];
+
+        explicit fragile(bool fail) : payload{} {
+            if (fail)
+                throw std::runtime_error("fragile");
+        }
+    };
+
+    template<int... Ns>
+    void emplace_all(any_map &map, std::integer_sequence<int, Ns...>) {
+        (map.emplace<property<Ns>>(property<Ns>{Ns}), ...);
+    }
+
+    template<int... Ns>
+    bool each_found(const any_map &map, std::integer_sequence<int, Ns...>) {
+        return ((map.get_if<property<Ns>>() != nullptr && map.get<property<Ns>>().value == Ns) && ...);
+    }
+
+    template<int... Ns>
+    void erase_even(any_map &map, std::integer_sequence<int, Ns...>) {
+        ((Ns % 2 == 0 ? (void)map.erase<property<Ns>>() : (void)0), ...);
+    }
+
+    template<int... Ns>
+    bool odd_found(const any_map &map, std::integer_sequence<int, Ns...>) {
+        return ((map.contains<property<Ns>>() == (Ns % 2 == 1)) && ...);
+    }
+}
+
+TEST_CASE("any_map tests") {
+    any_map map;
+    REQUIRE(map.empty());
+    REQUIRE(map.get_if<int>() == nullptr);
+    REQUIRE_THROWS_AS(map.get<int>(), bad_any_cast);
+
+    map.emplace<deadline>(deadline{250});
+    map.emplace<trace>(trace{"abc", {"parse", "plan"}});
+    map.insert_or_assign(42);
+    REQUIRE(map.size() == 3);
+
+    REQUIRE(map.get<deadline>().milliseconds == 250);
+    REQUIRE(map.get<trace>().spans.size() == 2);
+    REQUIRE(map.get<int>() == 42);
+    REQUIRE(map.contains<trace>());
+    REQUIRE_FALSE(map.contains<long>());
+
+    // one value per type, emplacing again replaces it
+    map.emplace<int>(7);
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.get<int>() == 7);
+
+    map.get<trace>().spans.push_back("execute");
+    const any_map &view = map;
+    REQUIRE(view.get_if<trace>()->spans.back() == "execute");
+
+    any_map copy = map;
+    REQUIRE(map.erase<trace>());
+    REQUIRE_FALSE(map.erase<trace>());
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.get_if<trace>() == nullptr);
+    REQUIRE(copy.get<trace>().id == "abc");
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE_FALSE(map.contains<int>());
+    map.emplace<int>(1);
+    REQUIRE(map.get<int>() == 1);
+}
+
+TEST_CASE("any_map growth and erasure") {
+    using all = std::make_integer_sequence<int, 100>;
+
+    any_map map;
+    emplace_all(map, all{});
+    REQUIRE(map.size() == 100);
+    REQUIRE(each_found(map, all{}));
+
+    // erasing moves back the values probed past the hole, every other one stays reachable
+    erase_even(map, all{});
+    REQUIRE(map.size() == 50);
+    REQUIRE(odd_found(map, all{}));
+
+    any_map moved = std::move(map);
+    REQUIRE(moved.size() == 50);
+    REQUIRE(odd_found(moved, all{}));
+}
+
+TEST_CASE("any_map emplace with a throwing constructor") {
+    any_map map;
+    REQUIRE_THROWS_AS(map.emplace<fragile>(true), std::runtime_error);
+    REQUIRE(map.empty());
+    REQUIRE_FALSE(map.contains<fragile>());
+
+    map.emplace<fragile>(false).payload[0] = 5;
+
+    // replacing a value keeps the old one when the new one cannot be constructed
+    REQUIRE_THROWS_AS(map.emplace<fragile>(true), std::runtime_error);
+    REQUIRE(map.size() == 1);
+    REQUIRE(map.contains<fragile>());
+    REQUIRE(map.get_if<fragile>() != nullptr);
+    REQUIRE(map.get<fragile>().payload[0] == 5);
+}
@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <cstdint>
+#include <memory_resource>
 
 TEST_CASE("any constructor with heap initialization tests") {
     // empty
@@ -197,7 +200,7 @@ TEST_CASE("any constructor with stack initialization") {
     // raw string
     any char_any("this is a raw string");
     const char *raw_str_cast = any_cast<const char*>(char_any);
-    REQUIRE(std::strcmp(raw_str_cast, "this is a raw string"));
+    REQUIRE(std::strcmp(raw_str_cast, "this is a raw string") == 0);
 
     // smart ptr
     std::shared_ptr<test> smrt_ptr = std::make_shared<test>(); 
@@ -291,6 +294,19 @@ TEST_CASE("any operator= tests") {
     std::shared_ptr<test> &mv_test_cast = any_cast<std::shared_ptr<test> &>(mv_smrt_ptr_any);
     REQUIRE(mv_test_cast.use_count() == 2);
     REQUIRE(test_cast == nullptr);
+
+    // another any flavour is converted, not stored as a value
+    using cache_line_any = basic_any<64, alignof(void*)>;
+    cache_line_any large_any = std::string("converted");
+    any converted_any;
+    converted_any = std::move(large_any);
+    REQUIRE(any_cast<std::string &>(converted_any) == "converted");
+
+    unique_any unique_str_any;
+    unique_str_any = std::move(converted_any);
+    REQUIRE(any_cast<std::string &>(unique_str_any) == "converted");
+
+    static_assert(!std::is_assignable_v<any &, std::in_place_type_t<int>>);
 }
 
 
@@ -362,4 +378,605 @@ TEST_CASE("any reset method") {
     REQUIRE(smrt_ptr.use_count() == 2);
     smrt_ptr_any.reset();
     REQUIRE(smrt_ptr.use_count() == 1);
-}
\ No newline at end of file
+}
+
+TEST_CASE("basic_any inline capacity tests") {
+    using cache_line_any = basic_any<64, alignof(void*)>;
+
+    struct message {
+        std::string topic;
+        int id;
+        double stamp;
+    };
+
+    REQUIRE(sizeof(cache_line_any) == 64 + sizeof(void*));
+    REQUIRE(any::is_stored_inline<std::string> == (sizeof(std::string) <= 2*sizeof(void*)));
+    REQUIRE(cache_line_any::is_stored_inline<std::string>);
+    REQUIRE(cache_line_any::is_stored_inline<message>);
+
+    // values are placed in the inline buffer
+    cache_line_any msg_any = message{"this is a topic", 3, 1.5};
+    message *msg_cast = any_cast<message>(&msg_any);
+    REQUIRE(msg_cast != nullptr);
+    REQUIRE(reinterpret_cast<char *>(msg_cast) >= reinterpret_cast<char *>(&msg_any));
+    REQUIRE(reinterpret_cast<char *>(msg_cast + 1) <= reinterpret_cast<char *>(&msg_any + 1));
+    REQUIRE(msg_cast->topic == "this is a topic");
+    REQUIRE(msg_cast->id == 3);
+
+    cache_line_any cp_msg_any = msg_any;
+    REQUIRE(any_cast<message &>(cp_msg_any).topic == "this is a topic");
+
+    cache_line_any mv_msg_any = std::move(msg_any);
+    REQUIRE(msg_any.has_value() == false);
+    REQUIRE(any_cast<message &>(mv_msg_any).topic == "this is a topic");
+
+    // values larger than the buffer still go to the heap
+    struct big {
+        char raw[128];
+    };
+    REQUIRE(cache_line_any::is_stored_inline<big> == false);
+    cache_line_any big_any = big{"this is a raw string"};
+    REQUIRE(std::strcmp(any_cast<big &>(big_any).raw, "this is a raw string") == 0);
+}
+
+namespace {
+    struct alignas(32) vec8f {
+        float lanes[8];
+    };
+
+    struct alignas(64) padded_counter {
+        long count;
+    };
+
+    template<class T, class Any>
+    bool is_aligned(Any &operand) {
+        return reinterpret_cast<std::uintptr_t>(any_cast<T>(&operand)) % alignof(T) == 0;
+    }
+}
+
+TEST_CASE("aligned_any tests") {
+    REQUIRE(aligned_any<32>::is_stored_inline<vec8f>);
+    REQUIRE(aligned_any<64>::is_stored_inline<padded_counter>);
+    REQUIRE(aligned_any<32>::is_stored_inline<padded_counter> == false);
+    REQUIRE(any::is_stored_inline<vec8f> == false);
+    REQUIRE(alignof(aligned_any<64>) == 64);
+
+    // inline values are aligned, also after copies and moves
+    aligned_any<32> vec_any = vec8f{{1, 2, 3, 4, 5, 6, 7, 8}};
+    aligned_any<32> cp_vec_any = vec_any;
+    aligned_any<32> mv_vec_any = std::move(cp_vec_any);
+    REQUIRE(is_aligned<vec8f>(vec_any));
+    REQUIRE(is_aligned<vec8f>(mv_vec_any));
+    REQUIRE(any_cast<vec8f &>(mv_vec_any).lanes[7] == 8);
+
+    std::vector<aligned_any<64>> counters(3, padded_counter{5});
+    for (aligned_any<64> &counter : counters)
+        REQUIRE(is_aligned<padded_counter>(counter));
+
+    // the heap path allocates with the alignment of the value, whatever the allocator
+    any heap_vec_any = vec8f{{1, 2, 3, 4, 5, 6, 7, 8}};
+    any heap_counter_any = padded_counter{6};
+    REQUIRE(is_aligned<vec8f>(heap_vec_any));
+    REQUIRE(is_aligned<padded_counter>(heap_counter_any));
+
+    basic_any<16, 8, std::allocator<std::byte>> std_counter_any = padded_counter{7};
+    REQUIRE(is_aligned<padded_counter>(std_counter_any));
+
+    pmr::any pmr_counter_any(std::allocator_arg, std::pmr::new_delete_resource(), padded_counter{8});
+    REQUIRE(is_aligned<padded_counter>(pmr_counter_any));
+
+    // converting to a smaller alignment moves the value to an aligned heap block and back
+    any converted_any = std::move(vec_any);
+    REQUIRE(is_aligned<vec8f>(converted_any));
+    aligned_any<32> back_any = std::move(converted_any);
+    REQUIRE(is_aligned<vec8f>(back_any));
+    REQUIRE(any_cast<vec8f &>(back_any).lanes[0] == 1);
+}
+
+
+TEST_CASE("any relocation tests") {
+    // points to itself, copying its bytes to another address would leave it pointing to the original
+    struct self_pointing {
+        self_pointing *self;
+        int value;
+
+        self_pointing(int value) : self{this}, value{value} {}
+        self_pointing(const self_pointing &other) : self{this}, value{other.value} {}
+        self_pointing(self_pointing &&other) noexcept : self{this}, value{other.value} {}
+        self_pointing &operator=(const self_pointing &) = delete;
+
+        bool valid() const {
+            return self == this;
+        }
+    };
+
+    REQUIRE(any::is_stored_inline<self_pointing>);
+    REQUIRE_FALSE(is_trivially_relocatable_v<self_pointing>);
+
+    any self_any = self_pointing{1};
+    any int_any = 2;
+    REQUIRE(any_cast<self_pointing &>(self_any).valid());
+
+    self_any.swap(int_any);
+    REQUIRE(any_cast<int>(self_any) == 2);
+    REQUIRE(any_cast<self_pointing &>(int_any).valid());
+    REQUIRE(any_cast<self_pointing &>(int_any).value == 1);
+
+    any other_self_any = self_pointing{3};
+    int_any.swap(other_self_any);
+    REQUIRE(any_cast<self_pointing &>(int_any).valid());
+    REQUIRE(any_cast<self_pointing &>(int_any).value == 3);
+    REQUIRE(any_cast<self_pointing &>(other_self_any).valid());
+    REQUIRE(any_cast<self_pointing &>(other_self_any).value == 1);
+
+    any mv_self_any = std::move(int_any);
+    REQUIRE(any_cast<self_pointing &>(mv_self_any).valid());
+
+    self_any = std::move(mv_self_any);
+    REQUIRE(any_cast<self_pointing &>(self_any).valid());
+    REQUIRE(any_cast<self_pointing &>(self_any).value == 3);
+
+    // std::string may point into its own small buffer
+    using cache_line_any = basic_any<64, alignof(void*)>;
+    cache_line_any str_any = std::string("short");
+    cache_line_any heap_any = std::vector<int>{1, 2, 3};
+    str_any.swap(heap_any);
+    REQUIRE(any_cast<std::string &>(heap_any) == "short");
+    REQUIRE(any_cast<std::vector<int> &>(str_any).size() == 3);
+
+    std::swap(self_any, other_self_any);
+    REQUIRE(any_cast<self_pointing &>(self_any).valid());
+    REQUIRE(any_cast<self_pointing &>(self_any).value == 1);
+}
+
+
+TEST_CASE("basic_any conversion between inline capacities tests") {
+    using cache_line_any = basic_any<64, alignof(void*)>;
+
+    std::shared_ptr<int> smrt_ptr = std::make_shared<int>(4);
+
+    // inline to inline
+    any small_any = smrt_ptr;
+    cache_line_any large_any = std::move(small_any);
+    REQUIRE(small_any.has_value() == false);
+    REQUIRE(large_any.type() == typeid(std::shared_ptr<int>));
+    REQUIRE(*any_cast<std::shared_ptr<int> &>(large_any) == 4);
+    REQUIRE(smrt_ptr.use_count() == 2);
+
+    // heap to inline
+    std::vector<std::string> strings{"this is string 1", "this is string 2"};
+    any heap_any = std::vector<std::string>(strings);
+    const std::string *first_str = &any_cast<std::vector<std::string> &>(heap_any).front();
+    large_any = std::move(heap_any);
+    REQUIRE(heap_any.has_value() == false);
+    REQUIRE(any_cast<std::vector<std::string> &>(large_any) == strings);
+    REQUIRE(&any_cast<std::vector<std::string> &>(large_any).front() == first_str);
+
+    // inline to heap
+    cache_line_any str_any = std::string("this is a string that does not fit");
+    any converted_any = std::move(str_any);
+    REQUIRE(str_any.has_value() == false);
+    REQUIRE(any_cast<std::string>(converted_any) == "this is a string that does not fit");
+
+    // copy conversion keeps the source
+    const cache_line_any const_any = smrt_ptr;
+    any cp_any = const_any;
+    REQUIRE(any_cast<std::shared_ptr<int>>(cp_any) == smrt_ptr);
+    REQUIRE(smrt_ptr.use_count() == 3);
+
+    // empty
+    cache_line_any empty_any = any();
+    REQUIRE(empty_any.has_value() == false);
+}
+
+
+TEST_CASE("any_cast type identification tests") {
+    REQUIRE(any_type_id<int>() == typeid(int));
+    REQUIRE(any_type_id<const int>() == any_type_id<int>());
+    REQUIRE(any_type_id<int>() != any_type_id<double>());
+
+    any int_any = 12;
+    REQUIRE(int_any.type() == any_type_id<int>());
+    REQUIRE(any_cast<int>(&int_any) != nullptr);
+    REQUIRE(*any_cast<const int>(&int_any) == 12);
+    REQUIRE(any_cast<double>(&int_any) == nullptr);
+    REQUIRE(any_cast<unsigned>(&int_any) == nullptr);
+
+    any empty_any;
+    REQUIRE(empty_any.type() == any_type_id<void>());
+    REQUIRE(any_cast<int>(&empty_any) == nullptr);
+    REQUIRE_THROWS_AS(any_cast<int>(empty_any), bad_any_cast);
+
+    // the vtable of a converted value matches the one of the target instantiation
+    basic_any<64, alignof(void*)> str_any = std::string("this is a test string");
+    any converted_any = std::move(str_any);
+    REQUIRE(any_cast<std::string>(&converted_any) != nullptr);
+    REQUIRE(any_cast<const std::string &>(converted_any) == "this is a test string");
+}
+
+TEST_CASE("try_any_cast and unchecked_any_cast tests") {
+    any int_any = 12;
+    any str_any = std::string("this is a test string");
+    any empty_any;
+
+    auto int_result = try_any_cast<int>(int_any);
+    REQUIRE(int_result.has_value());
+    REQUIRE(*int_result == 12);
+    *int_result = 13;
+    REQUIRE(any_cast<int>(int_any) == 13);
+
+    REQUIRE_FALSE(try_any_cast<double>(int_any));
+    REQUIRE_FALSE(try_any_cast<int>(empty_any));
+    REQUIRE(try_any_cast<double>(int_any).value_or(1.5) == 1.5);
+    REQUIRE(try_any_cast<int>(int_any).value_or(0) == 13);
+
+    const any &const_str_any = str_any;
+    auto str_result = try_any_cast<std::string>(const_str_any);
+    static_assert(std::is_same_v<decltype(*str_result), const std::string &>);
+    REQUIRE(str_result->size() == 21);
+
+    REQUIRE(unchecked_any_cast<int>(int_any) == 13);
+    unchecked_any_cast<std::string>(str_any) += "!";
+    REQUIRE(unchecked_any_cast<std::string>(const_str_any) == "this is a test string!");
+}
+
+
+// fails to compile when the variable has a dynamic initializer
+#if defined(__cpp_constinit)
+#define REQUIRE_CONSTINIT constinit
+#elif defined(__clang__)
+#define REQUIRE_CONSTINIT [[clang::require_constant_initialization]]
+#elif defined(__GNUC__)
+#define REQUIRE_CONSTINIT __constinit
+#else
+#define REQUIRE_CONSTINIT
+#endif
+
+namespace {
+    struct constant_pod {
+        int i;
+        int j;
+    };
+
+    // the bytes between i and d are padding
+    struct padded_pod {
+        int i;
+        double d;
+    };
+
+    static_assert(std::has_unique_object_representations_v<constant_pod>);
+    static_assert(!std::has_unique_object_representations_v<padded_pod>);
+
+    // constant-initialized, usable from any dynamic initializer regardless of order
+    REQUIRE_CONSTINIT any constant_empty_any;
+#ifdef ANY_CONSTANT_INIT
+    REQUIRE_CONSTINIT any constant_int_any = 42;
+    REQUIRE_CONSTINIT any constant_double_any = 0.5;
+    REQUIRE_CONSTINIT any constant_pod_any = constant_pod{7, 2};
+#else
+    any constant_int_any = 42;
+    any constant_double_any = 0.5;
+    any constant_pod_any = constant_pod{7, 2};
+#endif
+
+    // padding cannot be copied during constant evaluation, the value is initialized dynamically
+    any padded_pod_any = padded_pod{7, 2.5};
+}
+
+TEST_CASE("any constant initialization tests") {
+    REQUIRE(constant_empty_any.has_value() == false);
+    REQUIRE(any_cast<int>(constant_int_any) == 42);
+    REQUIRE(any_cast<double>(constant_double_any) == Approx(0.5));
+    REQUIRE(any_cast<constant_pod &>(constant_pod_any).i == 7);
+    REQUIRE(any_cast<constant_pod &>(constant_pod_any).j == 2);
+    REQUIRE(any_cast<padded_pod &>(padded_pod_any).i == 7);
+    REQUIRE(any_cast<padded_pod &>(padded_pod_any).d == Approx(2.5));
+
+    any cp_int_any = constant_int_any;
+    REQUIRE(any_cast<int>(cp_int_any) == 42);
+
+    constant_int_any = std::string("this is a test string");
+    REQUIRE(any_cast<std::string>(constant_int_any) == "this is a test string");
+    constant_int_any = 42;
+}
+
+
+TEST_CASE("any trivially copyable values tests") {
+    struct pod {
+        int i;
+        float f;
+    };
+
+    any pod_any = pod{3, 1.5f};
+    any cp_pod_any = pod_any;
+    REQUIRE(any_cast<pod &>(cp_pod_any).i == 3);
+    REQUIRE(any_cast<pod &>(cp_pod_any).f == Approx(1.5f));
+
+    any mv_pod_any = std::move(cp_pod_any);
+    REQUIRE(cp_pod_any.has_value() == false);
+    REQUIRE(any_cast<pod &>(mv_pod_any).i == 3);
+
+    // trivial to trivial assignment
+    any double_any = 3.14;
+    double_any = pod_any;
+    REQUIRE(double_any.type() == typeid(pod));
+    REQUIRE(any_cast<pod &>(double_any).i == 3);
+
+    // non trivial to trivial assignment releases the previous value
+    std::shared_ptr<int> smrt_ptr = std::make_shared<int>(1);
+    any smrt_ptr_any = smrt_ptr;
+    REQUIRE(smrt_ptr.use_count() == 2);
+    smrt_ptr_any = pod_any;
+    REQUIRE(smrt_ptr.use_count() == 1);
+    REQUIRE(any_cast<pod &>(smrt_ptr_any).i == 3);
+
+    // trivial to non trivial assignment
+    pod_any = smrt_ptr;
+    REQUIRE(smrt_ptr.use_count() == 2);
+    pod_any = std::move(mv_pod_any);
+    REQUIRE(smrt_ptr.use_count() == 1);
+    REQUIRE(mv_pod_any.has_value() == false);
+    REQUIRE(any_cast<pod &>(pod_any).i == 3);
+
+    pod_any.reset();
+    REQUIRE(pod_any.has_value() == false);
+    pod_any = pod_any;
+    REQUIRE(pod_any.has_value() == false);
+}
+
+
+TEST_CASE("unique_any tests") {
+    struct move_only_buffer {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+        char padding[64];
+
+        move_only_buffer(std::size_t size) : data{new char[size]}, size{size} {}
+        move_only_buffer(move_only_buffer &&) = default;
+    };
+
+    // move-only value stored inline
+    unique_any ptr_any = std::make_unique<int>(5);
+    REQUIRE(ptr_any.type() == typeid(std::unique_ptr<int>));
+    REQUIRE(unique_any::is_stored_inline<std::unique_ptr<int>>);
+    REQUIRE(*any_cast<std::unique_ptr<int> &>(ptr_any) == 5);
+
+    unique_any mv_ptr_any = std::move(ptr_any);
+    REQUIRE(ptr_any.has_value() == false);
+    REQUIRE(*any_cast<std::unique_ptr<int> &>(mv_ptr_any) == 5);
+
+    std::unique_ptr<int> extracted = any_cast<std::unique_ptr<int>>(std::move(mv_ptr_any));
+    REQUIRE(*extracted == 5);
+    REQUIRE(any_cast<std::unique_ptr<int> &>(mv_ptr_any) == nullptr);
+
+    // move-only value stored on the heap
+    unique_any buffer_any = move_only_buffer(32);
+    REQUIRE(unique_any::is_stored_inline<move_only_buffer> == false);
+    REQUIRE(any_cast<move_only_buffer &>(buffer_any).size == 32);
+    char *buffer_data = any_cast<move_only_buffer &>(buffer_any).data.get();
+
+    unique_any mv_buffer_any;
+    mv_buffer_any = std::move(buffer_any);
+    REQUIRE(buffer_any.has_value() == false);
+    REQUIRE(any_cast<move_only_buffer &>(mv_buffer_any).data.get() == buffer_data);
+
+    // conversion from a copyable any keeps the value where it is
+    std::string str("this is a string that is stored on the heap");
+    any str_any = str;
+    const std::string *str_ptr = any_cast<std::string>(&str_any);
+    unique_any converted_any = std::move(str_any);
+    REQUIRE(str_any.has_value() == false);
+    REQUIRE(any_cast<std::string>(&converted_any) == str_ptr);
+    REQUIRE(any_cast<const std::string &>(converted_any) == str);
+
+    basic_unique_any<64, alignof(void*)> large_any = std::move(converted_any);
+    REQUIRE(any_cast<std::string &>(large_any) == str);
+
+    // assignment and reset
+    converted_any = std::make_unique<int>(7);
+    REQUIRE(*any_cast<std::unique_ptr<int> &>(converted_any) == 7);
+    converted_any.reset();
+    REQUIRE(converted_any.has_value() == false);
+    REQUIRE(any_cast<int>(&converted_any) == nullptr);
+
+    // a copyable any cannot hold a move-only type, asking for one finds nothing
+    any int_any = 1;
+    const any &const_int_any = int_any;
+    REQUIRE(any_cast<std::unique_ptr<int>>(&int_any) == nullptr);
+    REQUIRE(any_cast<std::unique_ptr<int>>(&const_int_any) == nullptr);
+    REQUIRE_FALSE(try_any_cast<move_only_buffer>(int_any));
+}
+
+
+namespace {
+    class counting_resource : public std::pmr::memory_resource {
+    public:
+        std::size_t allocations = 0;
+        std::size_t deallocations = 0;
+        std::size_t bytes = 0;
+
+    private:
+        void *do_allocate(std::size_t size, std::size_t alignment) override {
+            ++allocations;
+            bytes += size;
+            return std::pmr::new_delete_resource()->allocate(size, alignment);
+        }
+
+        void do_deallocate(void *p, std::size_t size, std::size_t alignment) override {
+            ++deallocations;
+            std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+}
+
+namespace {
+    // counts how often it is built, copied and moved
+    struct aggregate {
+        static int constructions;
+        static int copies_and_moves;
+
+        std::string name;
+        std::vector<int> values;
+        char raw[64];
+
+        aggregate(std::string name, std::initializer_list<int> values)
+            : name{std::move(name)}, values{values}, raw{} { ++constructions; }
+        aggregate(const aggregate &other)
+            : name{other.name}, values{other.values}, raw{} { ++copies_and_moves; }
+        aggregate(aggregate &&other)
+            : name{std::move(other.name)}, values{std::move(other.values)}, raw{} { ++copies_and_moves; }
+        aggregate &operator=(const aggregate &) = default;
+    };
+
+    struct immovable {
+        int value;
+
+        explicit immovable(int value) : value{value} {}
+        immovable(const immovable &) = delete;
+        immovable(immovable &&) = delete;
+    };
+
+    int aggregate::constructions = 0;
+    int aggregate::copies_and_moves = 0;
+}
+
+TEST_CASE("any in-place construction tests") {
+    aggregate::constructions = 0;
+    aggregate::copies_and_moves = 0;
+
+    // in_place_type constructs the value where it is stored
+    any agg_any(std::in_place_type<aggregate>, "first", std::initializer_list<int>{1, 2, 3});
+    REQUIRE(aggregate::constructions == 1);
+    REQUIRE(aggregate::copies_and_moves == 0);
+    REQUIRE(any_cast<aggregate &>(agg_any).name == "first");
+    REQUIRE(any_cast<aggregate &>(agg_any).values.size() == 3);
+
+    any vec_any(std::in_place_type<std::vector<int>>, {4, 5, 6, 7});
+    REQUIRE(any_cast<std::vector<int> &>(vec_any).size() == 4);
+
+    any int_any(std::in_place_type<int>);
+    REQUIRE(any_cast<int>(int_any) == 0);
+
+    // emplace replaces the value and returns a reference to the new one
+    aggregate &emplaced = agg_any.emplace<aggregate>("second", std::initializer_list<int>{4});
+    REQUIRE(&emplaced == any_cast<aggregate>(&agg_any));
+    REQUIRE(emplaced.name == "second");
+    REQUIRE(aggregate::constructions == 2);
+    REQUIRE(aggregate::copies_and_moves == 0);
+
+    std::string &str = int_any.emplace<std::string>(3, 'a');
+    REQUIRE(str == "aaa");
+    REQUIRE(int_any.type() == typeid(std::string));
+
+    std::vector<int> &vec = vec_any.emplace<std::vector<int>>({1, 2});
+    REQUIRE(vec.size() == 2);
+
+    // assigning a value of the held type reuses the storage
+    const aggregate *storage = any_cast<aggregate>(&agg_any);
+    aggregate replacement("third", {7, 8});
+    agg_any = replacement;
+    REQUIRE(any_cast<aggregate>(&agg_any) == storage);
+    REQUIRE(storage->name == "third");
+    REQUIRE(aggregate::copies_and_moves == 0);
+
+    const std::string *str_storage = any_cast<std::string>(&int_any);
+    int_any = std::string("bbb");
+    REQUIRE(any_cast<std::string>(&int_any) == str_storage);
+    REQUIRE(any_cast<std::string &>(int_any) == "bbb");
+
+    // assigning another type still replaces the value
+    int_any = 5;
+    REQUIRE(any_cast<int>(int_any) == 5);
+
+    // types that cannot be moved live in a unique_any
+    unique_any immovable_any(std::in_place_type<immovable>, 6);
+    REQUIRE(any_cast<immovable &>(immovable_any).value == 6);
+    REQUIRE(immovable_any.emplace<immovable>(7).value == 7);
+
+    unique_any mv_immovable_any = std::move(immovable_any);
+    REQUIRE(immovable_any.has_value() == false);
+    REQUIRE(any_cast<immovable &>(mv_immovable_any).value == 7);
+
+    // an empty any after a throwing emplace
+    struct throwing {
+        throwing() { throw 1; }
+    };
+    REQUIRE_THROWS(agg_any.emplace<throwing>());
+    REQUIRE(agg_any.has_value() == false);
+}
+
+
+TEST_CASE("pmr::any allocation tests") {
+    struct big {
+        char raw[64];
+        int i;
+    };
+
+    counting_resource resource;
+
+    // values stored inline never touch the resource
+    pmr::any int_any(std::allocator_arg, &resource, 12);
+    REQUIRE(int_any.get_allocator().resource() == &resource);
+    REQUIRE(any_cast<int>(int_any) == 12);
+    REQUIRE(resource.allocations == 0);
+
+    // the heap path allocates from the resource
+    pmr::any big_any(std::allocator_arg, &resource, big{"this is a raw string", 3});
+    REQUIRE(resource.allocations == 1);
+    REQUIRE(resource.bytes == sizeof(big));
+    REQUIRE(any_cast<big &>(big_any).i == 3);
+
+    // assignment keeps the allocator of the target
+    int_any = big{"this is another raw string", 4};
+    REQUIRE(resource.allocations == 2);
+    int_any.reset();
+    REQUIRE(resource.deallocations == 1);
+
+    // move construction takes the allocator and the allocation of the source
+    pmr::any mv_big_any = std::move(big_any);
+    REQUIRE(mv_big_any.get_allocator().resource() == &resource);
+    REQUIRE(resource.allocations == 2);
+    REQUIRE(any_cast<big &>(mv_big_any).i == 3);
+
+    // allocator-extended copy
+    pmr::any cp_big_any(std::allocator_arg, &resource, mv_big_any);
+    REQUIRE(resource.allocations == 3);
+    REQUIRE(any_cast<big &>(cp_big_any).i == 3);
+
+    // a plain copy uses the default resource like the std::pmr containers
+    pmr::any default_any = mv_big_any;
+    REQUIRE(default_any.get_allocator().resource() == std::pmr::get_default_resource());
+    REQUIRE(resource.allocations == 3);
+
+    // moving into an any with another resource reallocates there
+    counting_resource other_resource;
+    pmr::any other_any(std::allocator_arg, &other_resource);
+    other_any = std::move(cp_big_any);
+    REQUIRE(cp_big_any.has_value() == false);
+    REQUIRE(resource.deallocations == 2);
+    REQUIRE(other_resource.allocations == 1);
+    REQUIRE(any_cast<big &>(other_any).i == 3);
+
+    // swapping anys with unequal allocators keeps each allocator
+    pmr::any str_any(std::allocator_arg, &resource, 1);
+    str_any.swap(other_any);
+    REQUIRE(str_any.get_allocator().resource() == &resource);
+    REQUIRE(any_cast<big &>(str_any).i == 3);
+    REQUIRE(any_cast<int>(other_any) == 1);
+    REQUIRE(other_resource.deallocations == 1);
+
+    // pmr aware payloads receive the allocator of the any
+    pmr::any pmr_str_any(std::allocator_arg, &resource, std::pmr::string("this is a long string that does not fit in the small buffer"));
+    REQUIRE(any_cast<std::pmr::string &>(pmr_str_any).get_allocator().resource() == &resource);
+
+    // a monotonic buffer frees a whole batch at once
+    std::pmr::monotonic_buffer_resource request_buffer;
+    std::vector<pmr::any> request_values;
+    for (int i = 0; i < 16; ++i)
+        request_values.emplace_back(std::allocator_arg, &request_buffer, big{"request value", i});
+    REQUIRE(any_cast<big &>(request_values[15]).i == 15);
+}
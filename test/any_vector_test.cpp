@@ -0,0 +1,116 @@
+#include "lib/catch.hpp"
+#include "src/any_vector.hpp"
+#include "test/tracked.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    using tracked_name = tracked<std::string>;
+
+    struct alignas(32) lanes {
+        float values[8];
+    };
+}
+
+TEST_CASE("any_vector tests") {
+    any_vector values;
+    REQUIRE(values.empty());
+    REQUIRE(any_vector::max_size() == UINT32_MAX);
+
+    values.push_back(1);
+    values.push_back(std::string("one"));
+    values.push_back(2);
+    values.emplace_back<std::string>(3, 'x');
+    values.push_back(1.5);
+    REQUIRE(values.size() == 5);
+
+    // positions keep the order of insertion
+    REQUIRE(values.type(0) == any_type_id<int>());
+    REQUIRE(values.type(1) == any_type_id<std::string>());
+    REQUIRE(values.get<int>(2) == 2);
+    REQUIRE(values.get<std::string>(3) == "xxx");
+    REQUIRE(*values.get_if<double>(4) == 1.5);
+    REQUIRE(values.get_if<int>(1) == nullptr);
+    REQUIRE_THROWS_AS(values.get<double>(0), bad_any_cast);
+
+    // each type is contiguous
+    REQUIRE(values.count<int>() == 2);
+    REQUIRE(values.count<std::string>() == 2);
+    REQUIRE(values.count<char>() == 0);
+    REQUIRE(values.data<int>()[1] == 2);
+    REQUIRE(values.data<char>() == nullptr);
+    REQUIRE(&values.get<int>(2) == values.data<int>() + 1);
+
+    std::vector<std::string> strings;
+    values.for_each<std::string>([&](const std::string &s) { strings.push_back(s); });
+    REQUIRE(strings == std::vector<std::string>{"one", "xxx"});
+
+    values.for_each<int>([](int &i) { i *= 10; });
+    REQUIRE(values.get<int>(0) == 10);
+
+    values.pop_back();
+    REQUIRE(values.size() == 4);
+    REQUIRE(values.count<double>() == 0);
+
+    // over-aligned values keep their alignment
+    values.push_back(lanes{{1, 2, 3, 4, 5, 6, 7, 8}});
+    values.push_back(lanes{{8, 7, 6, 5, 4, 3, 2, 1}});
+    REQUIRE(reinterpret_cast<std::uintptr_t>(values.data<lanes>()) % alignof(lanes) == 0);
+    REQUIRE(values.get<lanes>(5).values[0] == 8);
+}
+
+TEST_CASE("any_vector push_back without reserve tests") {
+    any_vector values;
+    for (int i = 0; i < 200000; ++i) {
+        if (i % 2 == 0)
+            values.push_back(i);
+        else
+            values.push_back(static_cast<double>(i));
+    }
+
+    REQUIRE(values.size() == 200000);
+    REQUIRE(values.count<int>() == 100000);
+    REQUIRE(values.get<int>(199998) == 199998);
+    REQUIRE(values.get<double>(199999) == 199999.0);
+}
+
+TEST_CASE("any_vector copy, move and clear tests") {
+    tracked_name::alive = 0;
+
+    {
+        any_vector values;
+        values.reserve<tracked_name>(16);
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(tracked_name{std::to_string(i)});
+            values.push_back(i);
+        }
+        REQUIRE(tracked_name::alive == 100);
+        REQUIRE(values.get<tracked_name>(198).value == "99");
+
+        any_vector copy = values;
+        REQUIRE(tracked_name::alive == 200);
+        REQUIRE(copy.get<tracked_name>(0).value == "0");
+        REQUIRE(copy.get<int>(199) == 99);
+
+        any_vector moved = std::move(copy);
+        REQUIRE(tracked_name::alive == 200);
+        REQUIRE(moved.size() == 200);
+
+        moved.clear();
+        REQUIRE(tracked_name::alive == 100);
+        REQUIRE(moved.empty());
+        REQUIRE(moved.count<tracked_name>() == 0);
+
+        moved.push_back(tracked_name{"again"});
+        REQUIRE(moved.get<tracked_name>(0).value == "again");
+
+        swap(moved, values);
+        REQUIRE(moved.size() == 200);
+        REQUIRE(values.size() == 1);
+    }
+
+    REQUIRE(tracked_name::alive == 0);
+}
@@ -0,0 +1,157 @@
+#include "lib/catch.hpp"
+#include "src/any_visit.hpp"
+
+#include <memory>
+#include <string>
+
+namespace {
+    struct big {
+        char raw[64];
+        int i;
+    };
+
+    struct describe {
+        std::string operator()(int i) const { return "int " + std::to_string(i); }
+        std::string operator()(double) const { return "double"; }
+        std::string operator()(const std::string &s) const { return "string " + s; }
+        std::string operator()(big &b) const { return "big " + std::to_string(b.i); }
+    };
+}
+
+TEST_CASE("visit tests") {
+    using list = TL::type_list<int, double, std::string, big>;
+    auto fallback = [](const any &operand) {
+        return std::string(operand.has_value() ? "unknown" : "empty");
+    };
+
+    any int_any = 3;
+    any double_any = 1.5;
+    any str_any = std::string("this is a test string");
+    any big_any = big{"this is a raw string", 7};
+    any char_any = 'c';
+    any empty_any;
+
+    REQUIRE(visit<list>(int_any, describe{}, fallback) == "int 3");
+    REQUIRE(visit<list>(double_any, describe{}, fallback) == "double");
+    REQUIRE(visit<list>(str_any, describe{}, fallback) == "string this is a test string");
+    REQUIRE(visit<list>(big_any, describe{}, fallback) == "big 7");
+    REQUIRE(visit<list>(char_any, describe{}, fallback) == "unknown");
+    REQUIRE(visit<list>(empty_any, describe{}, fallback) == "empty");
+
+    // the visitor gets a reference to the stored value
+    visit<list>(big_any, [](auto &value) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, big>)
+            value.i = 8;
+    });
+    REQUIRE(any_cast<big &>(big_any).i == 8);
+
+    const any &const_int_any = int_any;
+    REQUIRE(visit<list>(const_int_any, [](const auto &value) { return sizeof(value); }) == sizeof(int));
+
+    REQUIRE_THROWS_AS(visit<list>(char_any, describe{}), bad_any_cast);
+    REQUIRE_THROWS_AS(visit<list>(empty_any, describe{}), bad_any_cast);
+}
+
+TEST_CASE("visit with other any flavours tests") {
+    using list = TL::type_list<int, std::unique_ptr<int>>;
+
+    unique_any ptr_any = std::make_unique<int>(5);
+    int visited = 0;
+    visit<list>(ptr_any, [&](auto &value) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::unique_ptr<int>>)
+            visited = *value;
+    });
+    REQUIRE(visited == 5);
+
+    using cache_line_any = basic_any<64, alignof(void*)>;
+    cache_line_any big_any = big{"inline", 9};
+    REQUIRE(visit<TL::type_list<int, big>>(big_any, [](auto &value) -> int {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, big>)
+            return value.i;
+        else
+            return 0;
+    }) == 9);
+}
+
+namespace {
+    template<int N>
+    struct tag {
+        int value;
+    };
+}
+
+TEST_CASE("visit with a long type list tests") {
+    // longer lists find the type through a hashed index instead of a scan
+    using list = TL::type_list<tag<0>, tag<1>, tag<2>, tag<3>, tag<4>, tag<5>, tag<6>, tag<7>, tag<8>, tag<9>, tag<10>, tag<11>, tag<0>>;
+    auto value_of = [](const auto &t) { return t.value; };
+
+    any first_any = tag<0>{10};
+    any last_any = tag<11>{21};
+    any other_any = tag<12>{22};
+    REQUIRE(visit<list>(first_any, value_of) == 10);
+    REQUIRE(visit<list>(last_any, value_of) == 21);
+    REQUIRE(visit<list>(other_any, value_of, [](const any &) { return -1; }) == -1);
+}
+
+namespace {
+    struct circle {
+        double r;
+    };
+
+    struct box {
+        double w;
+    };
+
+    struct segment {
+        double l;
+    };
+
+    // only one order of each mixed pair is written
+    struct collide {
+        std::string operator()(const circle &, const circle &) const { return "circle circle"; }
+        std::string operator()(const circle &, const box &) const { return "circle box"; }
+        std::string operator()(const box &, const box &) const { return "box box"; }
+    };
+}
+
+TEST_CASE("visit2 tests") {
+    using shapes = TL::type_list<circle, box, segment>;
+    auto fallback = [](const any &a, const any &b) {
+        return std::string(a.has_value() && b.has_value() ? "unhandled" : "empty");
+    };
+
+    any c = circle{1};
+    any b = box{2};
+    any s = segment{3};
+    any i = 4;
+    any empty;
+
+    REQUIRE(visit2<shapes, shapes>(c, c, collide{}, fallback) == "circle circle");
+    REQUIRE(visit2<shapes, shapes>(c, b, collide{}, fallback) == "circle box");
+    REQUIRE(visit2<shapes, shapes>(b, c, collide{}, fallback) == "unhandled");
+    REQUIRE(visit2<shapes, shapes>(c, s, collide{}, fallback) == "unhandled");
+    REQUIRE(visit2<shapes, shapes>(c, i, collide{}, fallback) == "unhandled");
+    REQUIRE(visit2<shapes, shapes>(empty, c, collide{}, fallback) == "empty");
+
+    // symmetric dispatch passes the pair reversed when only the other order is handled
+    REQUIRE(visit2<shapes, shapes, true>(b, c, collide{}, fallback) == "circle box");
+    REQUIRE(visit2<shapes, shapes, true>(b, b, collide{}, fallback) == "box box");
+    REQUIRE(visit2<shapes, shapes, true>(s, c, collide{}, fallback) == "unhandled");
+
+    REQUIRE_THROWS_AS((visit2<shapes, shapes>(b, c, collide{})), bad_any_cast);
+    REQUIRE_THROWS_AS((visit2<shapes, shapes>(c, empty, collide{})), bad_any_cast);
+    REQUIRE(visit2<shapes, shapes, true>(b, c, collide{}) == "circle box");
+
+    // the lists may differ and the visitor gets references to the values
+    visit2<TL::type_list<circle>, TL::type_list<int, box>>(c, b, [](circle &x, auto &y) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(y)>, box>)
+            x.r = y.w;
+    });
+    REQUIRE(any_cast<circle &>(c).r == 2);
+
+    const any &const_b = b;
+    REQUIRE(visit2<shapes, shapes>(const_b, c, [](const auto &x, const auto &y) {
+        return sizeof(x) + sizeof(y);
+    }) == sizeof(box) + sizeof(circle));
+}
+
@@ -0,0 +1,121 @@
+#include "lib/catch.hpp"
+#include "src/arena_any.hpp"
+
+#include <string>
+#include <utility>
+
+namespace {
+    struct block {
+        long values[16];
+    };
+
+    struct counted {
+        static int destroyed;
+
+        std::string name;
+        long padding[4];
+
+        counted(std::string name) : name{std::move(name)}, padding{} {}
+        counted(const counted &other) = default;
+        ~counted() { ++destroyed; }
+    };
+
+    int counted::destroyed = 0;
+
+    bool within(const void *p, const unsigned char *buffer, std::size_t size) {
+        const unsigned char *byte = static_cast<const unsigned char *>(p);
+        return byte >= buffer && byte < buffer + size;
+    }
+}
+
+TEST_CASE("arena_any tests") {
+    alignas(std::max_align_t) unsigned char buffer[4096];
+    counted::destroyed = 0;
+    {
+        any_arena arena(buffer, sizeof(buffer));
+
+        // heap values come from the arena, small ones stay inline
+        arena_any small(std::allocator_arg, arena, 7);
+        arena_any large(std::allocator_arg, arena, block{{1, 2, 3}});
+        REQUIRE(any_cast<int>(small) == 7);
+        REQUIRE(any_cast<block &>(large).values[2] == 3);
+        REQUIRE(within(any_cast<block>(&large), buffer, sizeof(buffer)));
+
+        arena_any copy = large;
+        REQUIRE(within(any_cast<block>(&copy), buffer, sizeof(buffer)));
+        REQUIRE(any_cast<block>(&copy) != any_cast<block>(&large));
+
+        // values with a destructor are destroyed with their any
+        {
+            arena_any value(std::allocator_arg, arena, counted("first"));
+            REQUIRE(counted::destroyed == 1);
+            REQUIRE(any_cast<counted &>(value).name == "first");
+        }
+        REQUIRE(counted::destroyed == 2);
+
+        // or by the arena when their any lives in the arena too
+        arena_any &kept = arena.make<arena_any>(std::in_place_type<counted>, "kept");
+        REQUIRE(any_cast<counted &>(kept).name == "kept");
+
+        arena.reset();
+        REQUIRE(counted::destroyed == 3);
+
+        arena_any after(std::allocator_arg, arena, block{{4}});
+        REQUIRE(within(any_cast<block>(&after), buffer, sizeof(buffer)));
+    }
+    REQUIRE(counted::destroyed == 3);
+}
+
+TEST_CASE("arena_any placed in the arena") {
+    alignas(std::max_align_t) unsigned char buffer[4096];
+    any_arena arena(buffer, sizeof(buffer));
+    counted::destroyed = 0;
+
+    // the anys and their values share the arena and are dropped together by reset
+    for (int request = 0; request < 3; ++request) {
+        REQUIRE(arena.generation() == static_cast<std::size_t>(request));
+
+        arena_any &small = arena.make<arena_any>(request);
+        arena_any &large = arena.make<arena_any>(block{{request, 2}});
+        arena_any &named = arena.make<arena_any>(std::in_place_type<counted>, "request");
+        arena_unique_any &unique = arena.make<arena_unique_any>(std::in_place_type<block>);
+        REQUIRE(within(&small, buffer, sizeof(buffer)));
+        REQUIRE(within(&named, buffer, sizeof(buffer)));
+        REQUIRE(within(any_cast<block>(&large), buffer, sizeof(buffer)));
+        REQUIRE(within(any_cast<counted>(&named), buffer, sizeof(buffer)));
+        REQUIRE(any_cast<int>(small) == request);
+        REQUIRE(any_cast<block &>(large).values[0] == request);
+        REQUIRE(any_cast<counted &>(named).name == "request");
+        REQUIRE(unique.has_value());
+
+        // destroying an any in the arena early is still allowed before the reset
+        large.~arena_any();
+
+        REQUIRE(counted::destroyed == request);
+        arena.reset();
+        REQUIRE(counted::destroyed == request + 1);
+    }
+}
+
+TEST_CASE("arena_any across arenas") {
+    any_arena first;
+    any_arena second;
+    counted::destroyed = 0;
+
+    arena_any value(std::allocator_arg, first, std::in_place_type<counted>, "moved");
+    arena_any other(std::allocator_arg, second);
+    other = std::move(value);
+    REQUIRE(any_cast<counted &>(other).name == "moved");
+    REQUIRE(counted::destroyed == 1);
+
+    arena_unique_any unique(std::allocator_arg, first, std::in_place_type<block>);
+    arena_unique_any moved = std::move(unique);
+    REQUIRE(moved.has_value());
+    REQUIRE_FALSE(unique.has_value());
+
+    other.reset();
+    REQUIRE(counted::destroyed == 2);
+    first.reset();
+    second.reset();
+    REQUIRE(counted::destroyed == 2);
+}
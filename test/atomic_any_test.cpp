@@ -0,0 +1,98 @@
+#include "lib/catch.hpp"
+#include "src/atomic_any.hpp"
+#include "src/shared_any.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct settings {
+        static std::atomic<int> alive;
+
+        int version;
+        std::string name;
+
+        settings(int version, std::string name)
+            : version{version}, name{std::move(name)} { ++alive; }
+        settings(const settings &other)
+            : version{other.version}, name{other.name} { ++alive; }
+        settings(settings &&other) noexcept
+            : version{other.version}, name{std::move(other.name)} { ++alive; }
+        ~settings() { --alive; }
+    };
+
+    std::atomic<int> settings::alive{0};
+}
+
+TEST_CASE("atomic_any tests") {
+    atomic_any empty_value;
+    REQUIRE(empty_value.load().has_value() == false);
+
+    atomic_any value(any(1));
+    REQUIRE(any_cast<int>(value.load()) == 1);
+
+    value.store(std::string("this is a test string"));
+    REQUIRE(value.read([](const any &v) { return any_cast<const std::string &>(v).size(); }) == 21);
+
+    any old = value.exchange(2);
+    REQUIRE(any_cast<std::string &>(old) == "this is a test string");
+    REQUIRE(any_cast<int>(value.load()) == 2);
+
+    // compare_exchange compares the held value and reports it on failure
+    int expected = 3;
+    REQUIRE(value.compare_exchange(expected, 4) == false);
+    REQUIRE(expected == 2);
+    REQUIRE(value.compare_exchange(expected, 4));
+    REQUIRE(any_cast<int>(value.load()) == 4);
+
+    // a different type never compares equal and leaves expected alone
+    std::string expected_str = "4";
+    REQUIRE(value.compare_exchange(expected_str, 5) == false);
+    REQUIRE(expected_str == "4");
+    REQUIRE(any_cast<int>(value.load()) == 4);
+}
+
+TEST_CASE("atomic_any concurrent readers tests") {
+    settings::alive = 0;
+
+    {
+        basic_atomic_any<shared_any> current(shared_any(settings{0, "settings 0"}));
+        std::atomic<bool> done{false};
+        std::atomic<int> torn{0};
+
+        // every value a reader sees is whole and its version never goes back
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([&] {
+                int last = 0;
+                while (!done.load()) {
+                    int version = current.read([](const shared_any &v) {
+                        const settings &s = any_cast<const settings &>(v);
+                        return s.name == "settings " + std::to_string(s.version) ? s.version : -1;
+                    });
+
+                    shared_any copy = current.load();
+                    const settings &s = any_cast<const settings &>(copy);
+                    if (version < last || s.version < version || s.name != "settings " + std::to_string(s.version))
+                        ++torn;
+                    last = s.version;
+                }
+            });
+        }
+
+        for (int version = 1; version <= 2000; ++version)
+            current.store(settings{version, "settings " + std::to_string(version)});
+
+        done = true;
+        for (std::thread &reader : readers)
+            reader.join();
+
+        REQUIRE(torn == 0);
+        REQUIRE(any_cast<const settings &>(current.load()).version == 2000);
+        REQUIRE(settings::alive == 1);
+    }
+
+    REQUIRE(settings::alive == 0);
+}
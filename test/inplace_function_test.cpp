@@ -0,0 +1,117 @@
+#include "lib/catch.hpp"
+#include "src/inplace_function.hpp"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace {
+    int twice(int i) {
+        return 2 * i;
+    }
+
+    struct counter {
+        static int alive;
+
+        int calls = 0;
+
+        counter() { ++alive; }
+        counter(const counter &other) : calls{other.calls} { ++alive; }
+        counter(counter &&other) noexcept : calls{other.calls} { ++alive; }
+        ~counter() { --alive; }
+
+        int operator()() { return ++calls; }
+    };
+
+    int counter::alive = 0;
+
+    int apply(function_ref<int(int)> f, int i) {
+        return f(i);
+    }
+}
+
+TEST_CASE("inplace_function tests") {
+    inplace_function<int(int)> empty;
+    REQUIRE_FALSE(empty);
+    REQUIRE(empty == nullptr);
+    REQUIRE_THROWS_AS(empty(1), std::bad_function_call);
+
+    inplace_function<int(int)> function = twice;
+    REQUIRE(function(4) == 8);
+
+    int (*null_function)(int) = nullptr;
+    inplace_function<int(int)> null = null_function;
+    REQUIRE_FALSE(null);
+
+    // captures up to the capacity are stored inline
+    std::array<long, 4> captured = {1, 2, 3, 4};
+    inplace_function<long(long), 4*sizeof(long)> sum = [captured](long i) {
+        return captured[0] + captured[1] + captured[2] + captured[3] + i;
+    };
+    REQUIRE(sum(5) == 15);
+    REQUIRE(sizeof(sum) == 4*sizeof(long) + 2*sizeof(void*));
+
+    // copies have their own state, moves leave the source empty
+    counter::alive = 0;
+    {
+        inplace_function<int()> count = counter{};
+        REQUIRE(count() == 1);
+
+        inplace_function<int()> cp_count = count;
+        REQUIRE(cp_count() == 2);
+        REQUIRE(count() == 2);
+
+        inplace_function<int()> mv_count = std::move(count);
+        REQUIRE_FALSE(count);
+        REQUIRE_THROWS_AS(count(), std::bad_function_call);
+        REQUIRE(mv_count() == 3);
+
+        swap(mv_count, cp_count);
+        REQUIRE(mv_count() == 3);
+        REQUIRE(cp_count() == 4);
+
+        cp_count = nullptr;
+        REQUIRE_FALSE(cp_count);
+        REQUIRE(counter::alive == 1);
+
+        cp_count = [] { return 10; };
+        REQUIRE(cp_count() == 10);
+    }
+    REQUIRE(counter::alive == 0);
+
+    // arguments are forwarded
+    inplace_function<std::size_t(std::unique_ptr<std::string>)> take = [](std::unique_ptr<std::string> s) {
+        return s->size();
+    };
+    REQUIRE(take(std::make_unique<std::string>("four")) == 4);
+
+    inplace_function<void(std::string &)> append = [](std::string &s) { s += "!"; };
+    std::string s = "hi";
+    append(s);
+    REQUIRE(s == "hi!");
+}
+
+TEST_CASE("function_ref tests") {
+    REQUIRE(apply(twice, 3) == 6);
+    REQUIRE(apply(&twice, 3) == 6);
+
+    int offset = 10;
+    auto add = [&offset](int i) { return i + offset; };
+    REQUIRE(apply(add, 3) == 13);
+
+    // refers to the callable, state changes are seen by the owner
+    counter c;
+    function_ref<int()> ref = c;
+    REQUIRE(ref() == 1);
+    REQUIRE(ref() == 2);
+    REQUIRE(c.calls == 2);
+
+    inplace_function<int(int)> owned = [](int i) { return i * i; };
+    REQUIRE(apply(owned, 4) == 16);
+
+    function_ref<int(int)> cp_ref = add;
+    ref = c;
+    REQUIRE(cp_ref(1) == 11);
+}
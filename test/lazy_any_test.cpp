@@ -0,0 +1,108 @@
+#include "lib/catch.hpp"
+#include "src/lazy_any.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("lazy_any tests") {
+    int calls = 0;
+    lazy_any value(std::in_place_type<std::string>, [&calls] {
+        ++calls;
+        return std::string(40, 'x');
+    });
+
+    // answered from the factory
+    REQUIRE(value.has_value());
+    REQUIRE(value.type() == any_type_id<std::string>());
+    REQUIRE_FALSE(value.is_materialized());
+    REQUIRE(any_cast<int>(&value) == nullptr);
+    REQUIRE_THROWS_AS(any_cast<int>(value), bad_any_cast);
+    REQUIRE(calls == 0);
+
+    // made once
+    REQUIRE(any_cast<const std::string &>(value).size() == 40);
+    REQUIRE(value.is_materialized());
+    any_cast<std::string &>(value) += "y";
+    REQUIRE(any_cast<std::string>(value).back() == 'y');
+    REQUIRE(calls == 1);
+
+    // a copy of a made value does not call the factory
+    lazy_any made = value;
+    REQUIRE(made.is_materialized());
+    REQUIRE(any_cast<std::string>(made).size() == 41);
+    REQUIRE(calls == 1);
+
+    lazy_any deferred(std::in_place_type<std::string>, [&calls] {
+        ++calls;
+        return "deferred";
+    });
+    lazy_any copy = deferred;
+    REQUIRE_FALSE(copy.is_materialized());
+    REQUIRE(*any_cast<std::string>(&copy) == "deferred");
+    REQUIRE(*any_cast<std::string>(&deferred) == "deferred");
+    REQUIRE(calls == 3);
+
+    lazy_any moved = std::move(copy);
+    REQUIRE_FALSE(copy.has_value());
+    REQUIRE(any_cast<std::string>(moved) == "deferred");
+
+    moved.reset();
+    REQUIRE_FALSE(moved.has_value());
+    REQUIRE(moved.type() == any_type_id<void>());
+    REQUIRE(any_cast<std::string>(&moved) == nullptr);
+    REQUIRE_FALSE(lazy_any().value().has_value());
+
+    // the value cannot be replaced behind type(), a type the any cannot store is never found
+    static_assert(std::is_same_v<decltype(value.value()), const any &>);
+    REQUIRE(any_cast<std::unique_ptr<int>>(&value) == nullptr);
+    REQUIRE(any_cast<const std::string>(&value)->size() == 41);
+}
+
+TEST_CASE("lazy_any factory exceptions") {
+    int attempts = 0;
+    lazy_any value(std::in_place_type<int>, [&attempts] {
+        if (++attempts == 1)
+            throw std::runtime_error("not yet");
+        return 7;
+    });
+
+    REQUIRE_THROWS_AS(any_cast<int>(value), std::runtime_error);
+    REQUIRE_FALSE(value.is_materialized());
+    REQUIRE(any_cast<int>(value) == 7);
+    REQUIRE(attempts == 2);
+}
+
+TEST_CASE("lazy_unique_any tests") {
+    lazy_unique_any value;
+    value.defer<std::unique_ptr<int>>([] { return std::make_unique<int>(5); });
+    REQUIRE(value.type() == any_type_id<std::unique_ptr<int>>());
+    REQUIRE(**any_cast<std::unique_ptr<int>>(&value) == 5);
+
+    lazy_unique_any other = std::move(value);
+    REQUIRE(**any_cast<std::unique_ptr<int>>(&other) == 5);
+}
+
+TEST_CASE("lazy_any materializes once across threads") {
+    std::atomic<int> calls{0};
+    const lazy_any value(std::in_place_type<std::vector<int>>, [&calls] {
+        calls.fetch_add(1);
+        return std::vector<int>(1000, 3);
+    });
+
+    std::vector<std::thread> threads;
+    std::atomic<long> sum{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] {
+            sum += any_cast<const std::vector<int> &>(value)[999];
+        });
+    }
+    for (std::thread &t : threads)
+        t.join();
+
+    REQUIRE(calls == 1);
+    REQUIRE(sum == 24);
+}
@@ -0,0 +1,133 @@
+#include "lib/catch.hpp"
+#include "src/poly.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct point {
+        int x;
+        int y;
+        char padding[32];
+
+        bool operator==(const point &other) const { return x == other.x && y == other.y; }
+        bool operator<(const point &other) const { return x < other.x || (x == other.x && y < other.y); }
+    };
+
+    std::ostream &operator<<(std::ostream &os, const point &p) {
+        return os << "(" << p.x << ", " << p.y << ")";
+    }
+
+    struct serialize {
+        template<class T>
+        static void apply(const T &value, std::string &out) {
+            std::ostringstream os;
+            os << value;
+            out += os.str() + ";";
+        }
+    };
+
+    // a user operation taking a second operand of the stored type
+    struct distance {
+        template<class T>
+        static int apply(const T &lhs, const T &rhs) {
+            if constexpr (std::is_same_v<T, point>)
+                return std::abs(lhs.x - rhs.x) + std::abs(lhs.y - rhs.y);
+            else
+                return lhs == rhs ? 0 : 1;
+        }
+    };
+}
+
+TEST_CASE("poly hash and equality tests") {
+    using key = poly<any_ops::hash, any_ops::equal>;
+
+    std::unordered_map<key, int> counts;
+    counts[1] += 1;
+    counts[std::string("one")] += 1;
+    counts[1] += 1;
+    counts[1.0] += 1;
+    counts[std::string("one")] += 1;
+
+    REQUIRE(counts.size() == 3);
+    REQUIRE(counts[1] == 2);
+    REQUIRE(counts[std::string("one")] == 2);
+    REQUIRE(counts[1.0] == 1);
+
+    REQUIRE(key(1) == key(1));
+    REQUIRE(key(1) != key(2));
+    REQUIRE(key(1) != key(1L));
+    REQUIRE(key() == key());
+    REQUIRE(key() != key(0));
+    REQUIRE(std::hash<key>{}(key(5)) == std::hash<int>{}(5));
+}
+
+TEST_CASE("poly ordering and printing tests") {
+    using value = poly<any_ops::less, any_ops::ostream, serialize, distance>;
+    REQUIRE(value::any_type::is_stored_inline<point> == false);
+
+    std::vector<value> values = {3, point{2, 1, {}}, 1, value(), point{1, 5, {}}, 2};
+    std::sort(values.begin(), values.end());
+
+    // empty first, then grouped by type in a fixed order, sorted within each type
+    REQUIRE(values[0].has_value() == false);
+    std::vector<int> ints;
+    std::vector<point> points;
+    for (const value &v : values) {
+        if (const int *i = any_cast<int>(&v))
+            ints.push_back(*i);
+        if (const point *p = any_cast<point>(&v))
+            points.push_back(*p);
+    }
+    REQUIRE(ints == std::vector<int>{1, 2, 3});
+    REQUIRE(points == std::vector<point>{point{1, 5, {}}, point{2, 1, {}}});
+
+    std::ostringstream os;
+    os << value(point{1, 2, {}}) << " " << value(7) << value();
+    REQUIRE(os.str() == "(1, 2) 7");
+
+    std::string out;
+    for (const value &v : {value(1), value(point{3, 4, {}})})
+        v.call<serialize>(out);
+    REQUIRE(out == "1;(3, 4);");
+
+    value a = point{0, 0, {}};
+    value b = point{3, 4, {}};
+    REQUIRE(a.same_type(b));
+    REQUIRE(a.call<distance>(b.value()) == 7);
+
+    REQUIRE_THROWS_AS(value().call<serialize>(out), bad_any_cast);
+}
+
+TEST_CASE("poly value semantics tests") {
+    using value = poly<any_ops::equal, any_ops::ostream>;
+
+    value str = std::string("this is a test string");
+    value cp_str = str;
+    REQUIRE(cp_str == str);
+
+    value mv_str = std::move(cp_str);
+    REQUIRE(cp_str.has_value() == false);
+    REQUIRE(mv_str == str);
+
+    mv_str = 4;
+    REQUIRE(mv_str.type() == any_type_id<int>());
+    REQUIRE(*any_cast<int>(&mv_str) == 4);
+
+    mv_str.emplace<std::string>(3, 'x');
+    REQUIRE(mv_str == value(std::string("xxx")));
+
+    swap(mv_str, str);
+    REQUIRE(*any_cast<std::string>(&mv_str) == "this is a test string");
+    REQUIRE(any_cast<const std::string &>(str.value()) == "xxx");
+
+    str.reset();
+    REQUIRE(str.has_value() == false);
+    REQUIRE(any_cast<int>(&str) == nullptr);
+
+    value in_place(std::in_place_type<std::string>, "abc");
+    REQUIRE(in_place == value(std::string("abc")));
+}
@@ -0,0 +1,100 @@
+#include "lib/catch.hpp"
+#include "src/recycling_allocator.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace {
+    struct payload {
+        char bytes[512];
+        int id;
+    };
+
+    struct other_payload {
+        char bytes[1024];
+    };
+
+    struct tiny {
+        char c;
+    };
+}
+
+TEST_CASE("recycling_allocator tests") {
+    using allocator = recycling_allocator<payload>;
+    REQUIRE(allocator::capacity() == recycling_secret::default_capacity);
+
+    recycling_stats before = allocator::stats();
+    {
+        recycling_any value = payload{{}, 1};
+        REQUIRE(any_cast<payload &>(value).id == 1);
+    }
+    REQUIRE(allocator::cached() == 1);
+
+    // the block of the destroyed value is reused, copies included
+    const void *reused = nullptr;
+    {
+        recycling_any value = payload{{}, 2};
+        reused = any_cast<payload>(&value);
+        recycling_any copy = value;
+        REQUIRE(any_cast<payload &>(copy).id == 2);
+    }
+    REQUIRE(allocator::cached() == 2);
+    {
+        recycling_any value = payload{{}, 3};
+        REQUIRE(any_cast<payload>(&value) == reused);
+    }
+
+    recycling_stats after = allocator::stats();
+    REQUIRE(after.misses - before.misses == 2);
+    REQUIRE(after.hits - before.hits == 2);
+    REQUIRE(after.recycled - before.recycled == 4);
+    REQUIRE(after.hit_rate() > 0.0);
+
+    allocator::trim();
+    REQUIRE(allocator::cached() == 0);
+    REQUIRE(allocator::stats().released - before.released == 2);
+}
+
+TEST_CASE("recycling_allocator capacity and trimming") {
+    using allocator = recycling_allocator<other_payload>;
+    allocator::set_capacity(2);
+
+    {
+        std::vector<recycling_unique_any> values(5);
+        for (recycling_unique_any &value : values)
+            value.emplace<other_payload>();
+    }
+    REQUIRE(allocator::cached() == 2);
+
+    recycling_any value = payload{{}, 4};
+    value.reset();
+    REQUIRE(recycling_allocator<payload>::cached() == 1);
+
+    trim_recycling_allocators();
+    REQUIRE(allocator::cached() == 0);
+    REQUIRE(recycling_allocator<payload>::cached() == 0);
+    allocator::set_capacity(recycling_secret::default_capacity);
+
+    // too small to hold a link, passed through
+    recycling_allocator<tiny> tiny_allocator;
+    tiny *t = tiny_allocator.allocate(1);
+    tiny_allocator.deallocate(t, 1);
+    REQUIRE(recycling_allocator<tiny>::cached() == 0);
+}
+
+TEST_CASE("recycling_allocator threads") {
+    using allocator = recycling_allocator<payload>;
+    recycling_stats before = allocator::stats();
+
+    std::thread worker([] {
+        for (int i = 0; i < 10; ++i)
+            recycling_any value = payload{{}, i};
+    });
+    worker.join();
+
+    // the thread folded its counts and gave back its block when it exited
+    recycling_stats after = allocator::stats();
+    REQUIRE(after.misses - before.misses == 1);
+    REQUIRE(after.hits - before.hits == 9);
+    REQUIRE(after.released - before.released == 1);
+}
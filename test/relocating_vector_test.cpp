@@ -0,0 +1,139 @@
+#include "lib/catch.hpp"
+#include "src/relocating_vector.hpp"
+#include "src/any.hpp"
+#include "test/tracked.hpp"
+
+#include <string>
+
+namespace {
+    using tracked_int = tracked<int>;
+
+    struct relocated : tracked_int {
+        using tracked_int::tracked;
+    };
+}
+
+template<>
+struct is_trivially_relocatable<relocated> : std::true_type {};
+
+TEST_CASE("is_trivially_relocatable tests") {
+    REQUIRE(is_trivially_relocatable_v<int>);
+    REQUIRE(is_trivially_relocatable_v<relocated>);
+    REQUIRE_FALSE(is_trivially_relocatable_v<tracked_int>);
+    REQUIRE_FALSE(is_trivially_relocatable_v<std::string>);
+
+    // any may hold inline values that cannot be relocated bitwise
+    REQUIRE_FALSE(is_trivially_relocatable_v<any>);
+    REQUIRE(std::is_nothrow_move_constructible_v<any>);
+    REQUIRE(std::is_nothrow_move_assignable_v<any>);
+    REQUIRE(std::is_nothrow_move_constructible_v<pmr::any>);
+}
+
+TEST_CASE("relocating_vector growth tests") {
+    tracked_int::moves = 0;
+    tracked_int::copies = 0;
+
+    SECTION("elements that are not trivially relocatable are moved") {
+        relocating_vector<tracked_int> values;
+        for (int i = 0; i < 100; ++i)
+            values.emplace_back(i);
+
+        REQUIRE(values.size() == 100);
+        REQUIRE(values.capacity() >= 100);
+        REQUIRE(tracked_int::copies == 0);
+        REQUIRE(tracked_int::moves > 0);
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(values[i].value == i);
+    }
+
+    SECTION("trivially relocatable elements are neither moved nor copied by reserve") {
+        relocating_vector<relocated> values;
+        for (int i = 0; i < 4; ++i)
+            values.emplace_back(i);
+
+        tracked_int::moves = 0;
+        values.reserve(1000);
+        REQUIRE(tracked_int::moves == 0);
+        REQUIRE(tracked_int::copies == 0);
+        REQUIRE(values.back().value == 3);
+    }
+
+    REQUIRE(tracked_int::alive == 0);
+}
+
+TEST_CASE("relocating_vector of any tests") {
+    struct big {
+        char raw[64];
+        int i;
+    };
+
+    relocating_vector<any> values;
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 2 == 0)
+            values.emplace_back(i);
+        else
+            values.emplace_back(big{"heap", i});
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 2 == 0)
+            REQUIRE(any_cast<int>(values[i]) == i);
+        else
+            REQUIRE(any_cast<big &>(values[i]).i == i);
+    }
+
+    relocating_vector<any> copies = values;
+    values.clear();
+    REQUIRE(values.empty());
+    REQUIRE(copies.size() == 1000);
+    REQUIRE(any_cast<big &>(copies.back()).i == 999);
+
+    relocating_vector<any> moved = std::move(copies);
+    REQUIRE(copies.empty());
+    REQUIRE(any_cast<int>(moved[0]) == 0);
+    moved.pop_back();
+    REQUIRE(moved.size() == 999);
+}
+
+TEST_CASE("relocating_vector of relocatable_any tests") {
+    // values that cannot be relocated bitwise go to the heap, so the any can be
+    REQUIRE(is_trivially_relocatable_v<relocatable_any>);
+    REQUIRE(is_trivially_relocatable_v<relocatable_unique_any>);
+    REQUIRE(relocatable_any::is_stored_inline<int>);
+    REQUIRE(relocatable_any::is_stored_inline<relocated>);
+    REQUIRE_FALSE(relocatable_any::is_stored_inline<tracked_int>);
+    REQUIRE(any::is_stored_inline<tracked_int>);
+
+    tracked_int::moves = 0;
+    tracked_int::alive = 0;
+
+    {
+        relocating_vector<relocatable_any> values;
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 2 == 0)
+                values.emplace_back(i);
+            else
+                values.emplace_back(tracked_int{i});
+        }
+
+        // growing reallocates the anys without touching the values they hold
+        int moves = tracked_int::moves;
+        values.reserve(100000);
+        REQUIRE(tracked_int::moves == moves);
+        REQUIRE(tracked_int::alive == 500);
+
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 2 == 0)
+                REQUIRE(any_cast<int>(values[i]) == i);
+            else
+                REQUIRE(any_cast<tracked_int &>(values[i]).value == i);
+        }
+
+        // conversions between buffer sizes keep tracked values on the heap
+        basic_relocatable_any<64, alignof(void*)> large = std::move(values[1]);
+        REQUIRE_FALSE(decltype(large)::is_stored_inline<tracked_int>);
+        REQUIRE(any_cast<tracked_int &>(large).value == 1);
+    }
+
+    REQUIRE(tracked_int::alive == 0);
+}
@@ -0,0 +1,169 @@
+#include "lib/catch.hpp"
+#include "src/shared_any.hpp"
+
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct document {
+        static int alive;
+        static int copies;
+
+        std::string title;
+        std::vector<int> body;
+
+        document(std::string title, std::vector<int> body)
+            : title{std::move(title)}, body{std::move(body)} { ++alive; }
+        document(const document &other)
+            : title{other.title}, body{other.body} { ++alive; ++copies; }
+        document(document &&other) noexcept
+            : title{std::move(other.title)}, body{std::move(other.body)} { ++alive; }
+        document &operator=(const document &) = default;
+        ~document() { --alive; }
+    };
+
+    int document::alive = 0;
+    int document::copies = 0;
+
+    class counting_resource : public std::pmr::memory_resource {
+    public:
+        int allocations = 0;
+        int deallocations = 0;
+
+    private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+            ++deallocations;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+}
+
+TEST_CASE("shared_any copy-on-write tests") {
+    document::alive = 0;
+    document::copies = 0;
+
+    {
+        shared_any original = document{"title", {1, 2, 3}};
+        REQUIRE(shared_any::is_stored_inline<document> == false);
+
+        // copies share the value
+        shared_any first = original;
+        shared_any second = first;
+        REQUIRE(document::alive == 1);
+        REQUIRE(document::copies == 0);
+        REQUIRE(any_cast<document>(&std::as_const(first)) == any_cast<document>(&std::as_const(original)));
+        REQUIRE(any_cast<const document &>(std::as_const(second)).title == "title");
+
+        // writing through a non-const any_cast copies the shared value first
+        document &written = any_cast<document &>(second);
+        REQUIRE(document::alive == 2);
+        REQUIRE(document::copies == 1);
+        written.title = "changed";
+        REQUIRE(any_cast<const document &>(std::as_const(original)).title == "title");
+        REQUIRE(any_cast<const document &>(std::as_const(first)).title == "title");
+
+        // a sole owner writes in place
+        REQUIRE(any_cast<document>(&second) == &written);
+        REQUIRE(document::copies == 1);
+
+        // assigning the held type to a shared value makes a new block without copying the old value
+        first = document{"assigned", {}};
+        REQUIRE(document::copies == 1);
+        REQUIRE(any_cast<const document &>(std::as_const(first)).title == "assigned");
+        REQUIRE(any_cast<const document &>(std::as_const(original)).title == "title");
+
+        // moving hands the block over
+        const document *shared = any_cast<document>(&std::as_const(original));
+        shared_any moved = std::move(original);
+        REQUIRE(original.has_value() == false);
+        REQUIRE(any_cast<document>(&std::as_const(moved)) == shared);
+
+        second.reset();
+        REQUIRE(document::alive == 2);
+    }
+
+    REQUIRE(document::alive == 0);
+}
+
+TEST_CASE("shared_any read-only casts and kept references tests") {
+    document::alive = 0;
+    document::copies = 0;
+
+    {
+        shared_any original = document{"title", {1, 2, 3}};
+        shared_any copy = original;
+
+        // const targets read the shared value without copying it
+        REQUIRE(any_cast<const document &>(copy).title == "title");
+        REQUIRE(any_cast<const document>(&copy) == any_cast<document>(&std::as_const(original)));
+        REQUIRE(any_cast<document>(copy).body.size() == 3);
+        REQUIRE(document::copies == 1);
+        REQUIRE(document::alive == 1);
+
+        // a reference kept from a non-const cast stays private to its any, later copies get their own value
+        copy.reset();
+        document &kept = any_cast<document &>(original);
+        REQUIRE(document::copies == 1);
+        shared_any later = original;
+        REQUIRE(document::copies == 2);
+        kept.body.push_back(4);
+        REQUIRE(any_cast<const document &>(later).body.size() == 3);
+        REQUIRE(any_cast<const document &>(original).body.size() == 4);
+    }
+
+    REQUIRE(document::alive == 0);
+}
+
+TEST_CASE("shared_any inline and conversion tests") {
+    // small values are still copied
+    shared_any int_any = 5;
+    shared_any cp_int_any = int_any;
+    any_cast<int &>(cp_int_any) = 6;
+    REQUIRE(any_cast<int>(int_any) == 5);
+    REQUIRE(any_cast<int>(cp_int_any) == 6);
+
+    // a shared value moving to a larger inline buffer is copied out of the block
+    shared_any str_any = std::string("this is a rather long test string");
+    shared_any cp_str_any = str_any;
+    basic_shared_any<64, alignof(void*)> large_any = std::move(cp_str_any);
+    REQUIRE(decltype(large_any)::is_stored_inline<std::string>);
+    REQUIRE(any_cast<std::string &>(large_any) == "this is a rather long test string");
+    any_cast<std::string &>(large_any) = "changed";
+    REQUIRE(any_cast<std::string &>(str_any) == "this is a rather long test string");
+}
+
+TEST_CASE("pmr::shared_any allocation tests") {
+    counting_resource first_resource;
+    counting_resource second_resource;
+
+    {
+        pmr::shared_any first(std::allocator_arg, &first_resource, document{"title", {1}});
+        REQUIRE(first_resource.allocations == 1);
+
+        // the block is shared across resources and freed with the resource that made it
+        pmr::shared_any second(std::allocator_arg, &second_resource, first);
+        REQUIRE(second_resource.allocations == 0);
+        first.reset();
+        REQUIRE(first_resource.deallocations == 0);
+
+        // the copy made on write comes from the resource of the block
+        pmr::shared_any third = second;
+        any_cast<document &>(third).title = "changed";
+        REQUIRE(first_resource.allocations == 2);
+        REQUIRE(any_cast<const document &>(std::as_const(second)).title == "title");
+    }
+
+    REQUIRE(first_resource.deallocations == 2);
+    REQUIRE(second_resource.allocations == 0);
+}
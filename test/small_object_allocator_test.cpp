@@ -0,0 +1,152 @@
+#include "lib/catch.hpp"
+#include "src/small_object_allocator.hpp"
+#include "src/any.hpp"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct alignas(64) over_aligned {
+        char raw[64];
+    };
+
+    struct block {
+        char raw[48];
+    };
+}
+
+TEST_CASE("small_object_allocator reuse tests") {
+    small_object_allocator<block> alloc;
+
+    block *first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+
+    // the thread cache hands back the block freed last
+    block *second = alloc.allocate(1);
+    REQUIRE(first == second);
+    alloc.deallocate(second, 1);
+
+    // objects of the same size class share blocks
+    small_object_allocator<char> char_alloc(alloc);
+    char *chars = char_alloc.allocate(40);
+    REQUIRE(static_cast<void *>(chars) == static_cast<void *>(first));
+    char_alloc.deallocate(chars, 40);
+
+    REQUIRE(alloc == char_alloc);
+    REQUIRE_FALSE(alloc != char_alloc);
+}
+
+TEST_CASE("small_object_allocator size class tests") {
+    small_object_allocator<char> alloc;
+
+    for (std::size_t size = 17; size <= 256; size += 17) {
+        std::vector<char *> blocks;
+        for (int i = 0; i < 100; ++i) {
+            char *p = alloc.allocate(size);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(p) % alignof(std::max_align_t) == 0);
+            p[0] = 'a';
+            p[size - 1] = 'z';
+            blocks.push_back(p);
+        }
+
+        REQUIRE(small_object_allocator<char>::chunk_count(size) > 0);
+        for (char *p : blocks)
+            alloc.deallocate(p, size);
+    }
+
+    // larger objects and over-aligned objects are left to operator new
+    REQUIRE(small_object_allocator<char>::chunk_count(1024) == 0);
+    char *large = alloc.allocate(1024);
+    alloc.deallocate(large, 1024);
+
+    small_object_allocator<over_aligned> aligned_alloc;
+    over_aligned *aligned = aligned_alloc.allocate(1);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+    aligned_alloc.deallocate(aligned, 1);
+}
+
+TEST_CASE("small_object_allocator cross thread tests") {
+    small_object_allocator<block> alloc;
+    std::vector<block *> blocks(1000);
+
+    // blocks allocated on one thread and released on another flow back through the shared lists
+    std::thread producer([&] {
+        for (block *&p : blocks) {
+            p = alloc.allocate(1);
+            p->raw[0] = 'p';
+        }
+    });
+    producer.join();
+
+    std::thread consumer([&] {
+        for (block *p : blocks) {
+            REQUIRE(p->raw[0] == 'p');
+            alloc.deallocate(p, 1);
+        }
+    });
+    consumer.join();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&] {
+            std::vector<block *> local;
+            for (int round = 0; round < 50; ++round) {
+                for (int i = 0; i < 100; ++i)
+                    local.push_back(alloc.allocate(1));
+                for (block *p : local)
+                    alloc.deallocate(p, 1);
+                local.clear();
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+namespace {
+    // destroyed after the thread cache of its thread, as it is constructed first
+    struct late_user {
+        bool *done = nullptr;
+
+        ~late_user() {
+            small_object_allocator<block> alloc;
+            block *p = alloc.allocate(1);
+            p->raw[0] = 'l';
+            *done = p->raw[0] == 'l';
+            alloc.deallocate(p, 1);
+        }
+    };
+}
+
+TEST_CASE("small_object_allocator thread shutdown tests") {
+    bool done = false;
+
+    // a thread local destroyed after the cache allocates without reviving it
+    std::thread worker([&] {
+        thread_local late_user user;
+        user.done = &done;
+
+        small_object_allocator<block> alloc;
+        alloc.deallocate(alloc.allocate(1), 1);
+    });
+    worker.join();
+    REQUIRE(done);
+}
+
+TEST_CASE("any small object allocation tests") {
+    struct big {
+        char raw[64];
+        int i;
+    };
+
+    REQUIRE(std::is_same_v<any::allocator_type, small_object_allocator<std::byte>>);
+
+    any big_any = big{"this is a raw string", 3};
+    REQUIRE(small_object_allocator<char>::chunk_count(sizeof(big)) > 0);
+    REQUIRE(any_cast<big &>(big_any).i == 3);
+
+    any cp_big_any = big_any;
+    REQUIRE(any_cast<big &>(cp_big_any).i == 3);
+    REQUIRE(any_cast<big>(&cp_big_any) != any_cast<big>(&big_any));
+}
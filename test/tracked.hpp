@@ -0,0 +1,23 @@
+#ifndef TRACKED_HPP
+#define TRACKED_HPP
+
+#include <utility>
+
+// a value counting its live instances, copies and moves, to check that containers neither leak nor copy.
+// Each T has its own counters, which tests reset before use
+template<class T>
+struct tracked {
+    static inline int alive = 0;
+    static inline int copies = 0;
+    static inline int moves = 0;
+
+    T value;
+
+    tracked(T value) : value{std::move(value)} { ++alive; }
+    tracked(const tracked &other) : value{other.value} { ++copies; ++alive; }
+    tracked(tracked &&other) noexcept : value{std::move(other.value)} { ++moves; ++alive; }
+    tracked &operator=(const tracked &) = default;
+    ~tracked() { --alive; }
+};
+
+#endif
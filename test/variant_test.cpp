@@ -0,0 +1,134 @@
+#include "lib/catch.hpp"
+#include "src/variant.hpp"
+#include "test/tracked.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    using tracked_name = tracked<std::string>;
+
+    template<int N>
+    struct tag {
+        char raw[N];
+    };
+}
+
+TEST_CASE("TL::variant layout tests") {
+    using small = TL::variant<TL::type_list<char, short, int>>;
+    REQUIRE(small::size == 3);
+    REQUIRE(sizeof(small) == 2 * sizeof(int));
+    REQUIRE(alignof(small) == alignof(int));
+
+    using mixed = TL::variant<TL::type_list<tag<3>, tag<5>, char>>;
+    REQUIRE(sizeof(mixed) == 6);
+
+    // the discriminator grows with the number of types
+    using wide = TL::variant<TL::type_list<
+        tag<1>, tag<2>, tag<3>, tag<4>, tag<5>, tag<6>, tag<7>, tag<8>, tag<9>, tag<10>>>;
+    REQUIRE(sizeof(wide) == 11);
+    REQUIRE(sizeof(TL::variant<TL::type_list<double, std::string>>) == sizeof(std::string) + alignof(std::string));
+}
+
+TEST_CASE("TL::variant value tests") {
+    using value = TL::variant<TL::type_list<int, double, std::string>>;
+
+    value empty;
+    REQUIRE(empty.has_value() == false);
+    REQUIRE(empty.index() == value::npos);
+    REQUIRE_THROWS_AS(empty.visit([](const auto &) { return 0; }), std::bad_variant_access);
+
+    value int_value = 12;
+    REQUIRE(int_value.index() == 0);
+    REQUIRE(int_value.holds<int>());
+    REQUIRE(int_value.get<int>() == 12);
+    REQUIRE(TL::get_if<double>(&int_value) == nullptr);
+    REQUIRE_THROWS_AS(int_value.get<double>(), std::bad_variant_access);
+
+    value str_value = std::string("this is a test string");
+    REQUIRE(str_value.index() == 2);
+    REQUIRE(*TL::get_if<std::string>(&str_value) == "this is a test string");
+
+    // visit calls the visitor with the held type
+    auto describe = [](const auto &v) -> std::string {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, int>)
+            return "int";
+        else if constexpr (std::is_same_v<T, double>)
+            return "double";
+        else
+            return "string " + v;
+    };
+    REQUIRE(TL::visit(describe, int_value) == "int");
+    REQUIRE(TL::visit(describe, value(1.5)) == "double");
+    REQUIRE(str_value.visit(describe) == "string this is a test string");
+
+    str_value.visit([](auto &v) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::string>)
+            v += "!";
+    });
+    REQUIRE(str_value.get<std::string>() == "this is a test string!");
+
+    // assignment of the held type assigns in place, another type replaces the value
+    int_value = 13;
+    REQUIRE(int_value.get<int>() == 13);
+    int_value = 2.5;
+    REQUIRE(int_value.get<double>() == 2.5);
+
+    value in_place(std::in_place_type<std::string>, 3, 'x');
+    REQUIRE(in_place.get<std::string>() == "xxx");
+    in_place.emplace<int>(4);
+    REQUIRE(in_place.get<int>() == 4);
+}
+
+TEST_CASE("TL::variant lifetime tests") {
+    using value = TL::variant<TL::type_list<int, tracked_name>>;
+    tracked_name::alive = 0;
+
+    {
+        value first = tracked_name{"first"};
+        REQUIRE(tracked_name::alive == 1);
+
+        value copy = first;
+        REQUIRE(tracked_name::alive == 2);
+        REQUIRE(copy.get<tracked_name>().value == "first");
+
+        value moved = std::move(copy);
+        REQUIRE(copy.has_value() == false);
+        REQUIRE(tracked_name::alive == 2);
+
+        moved = 5;
+        REQUIRE(tracked_name::alive == 1);
+
+        swap(first, moved);
+        REQUIRE(first.get<int>() == 5);
+        REQUIRE(moved.get<tracked_name>().value == "first");
+
+        moved.reset();
+        REQUIRE(tracked_name::alive == 0);
+
+        std::vector<value> values;
+        for (int i = 0; i < 16; ++i)
+            values.emplace_back(tracked_name{std::to_string(i)});
+        REQUIRE(tracked_name::alive == 16);
+        REQUIRE(values[15].get<tracked_name>().value == "15");
+    }
+
+    REQUIRE(tracked_name::alive == 0);
+}
+
+TEST_CASE("TL::variant move-only types tests") {
+    using value = TL::variant<TL::type_list<int, std::unique_ptr<int>>>;
+
+    value ptr(std::in_place_type<std::unique_ptr<int>>, std::make_unique<int>(6));
+    value mv_ptr = std::move(ptr);
+    REQUIRE(ptr.has_value() == false);
+    REQUIRE(*mv_ptr.get<std::unique_ptr<int>>() == 6);
+
+    ptr = std::make_unique<int>(7);
+    swap(ptr, mv_ptr);
+    REQUIRE(*ptr.get<std::unique_ptr<int>>() == 6);
+    REQUIRE(*mv_ptr.get<std::unique_ptr<int>>() == 7);
+}